@@ -155,3 +155,18 @@ public:
     finished |= carry;
   }
 };
+
+// Used when the search has no per-cell timers, so that copies of the
+// search state don't carry any counters.
+template <>
+class LifeCountdown<0> {
+public:
+  static constexpr LifeState finished = LifeState();
+
+  LifeCountdown() {};
+  LifeCountdown(uint32_t) {};
+
+  void Start(const LifeState &) {}
+  void Reset(const LifeState &) {}
+  void Tick() {}
+};
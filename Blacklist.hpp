@@ -0,0 +1,122 @@
+#pragma once
+
+#include <fstream>
+#include <stdexcept>
+
+#include "LifeAPI.h"
+#include "LifeHistoryState.hpp"
+#include "Parsing.hpp"
+
+// A boring catalyst interaction: a stable shape, cells near it that
+// must have been active, and cells that must not have been.
+struct BlacklistTemplate {
+  LifeState stable;
+  LifeState active;
+  LifeState inactive;
+
+  // In LifeHistory, ON cells are the stable shape, history cells must
+  // have been active and marked OFF cells must not have been.
+  static BlacklistTemplate Parse(const std::string &rle) {
+    LifeHistoryState pat = ParseLifeHistoryWHeader(rle);
+    return {pat.state, pat.history, pat.marked & ~pat.state};
+  }
+
+  void Transform(SymmetryTransform t) {
+    stable.Transform(t);
+    active.Transform(t);
+    inactive.Transform(t);
+  }
+
+  void Move(int x, int y) {
+    stable.Move(x, y);
+    active.Move(x, y);
+    inactive.Move(x, y);
+  }
+
+  bool operator==(const BlacklistTemplate &other) const {
+    return stable == other.stable && active == other.active && inactive == other.inactive;
+  }
+};
+
+class Blacklist {
+public:
+  // Orientations of the templates, grouped by stable shape so that each
+  // shape only has to be located once
+  struct Group {
+    LifeState stable;
+    std::vector<std::pair<LifeState, LifeState>> activeInactive;
+  };
+  std::vector<Group> groups;
+
+  void Add(const BlacklistTemplate &t);
+  void AddFile(const std::string &filename);
+  void AddEater2() { Add(BlacklistTemplate::Parse("2AD$2AB$DBD!")); }
+
+  bool IsEmpty() const { return groups.empty(); }
+  bool Matches(const LifeState &stable, const LifeState &everActive) const;
+};
+
+inline void Blacklist::Add(const BlacklistTemplate &t) {
+  auto allTransforms = {
+      Identity,           ReflectAcrossXEven,   ReflectAcrossYeqX,
+      ReflectAcrossYEven, ReflectAcrossYeqNegX, Rotate90Even,
+      Rotate270Even,      Rotate180EvenBoth};
+
+  for (auto sym : allTransforms) {
+    BlacklistTemplate transformed = t;
+    transformed.Transform(sym);
+    // Normalise on the stable shape, so equal shapes share a group
+    auto [x, y, _x2, _y2] = transformed.stable.XYBounds();
+    transformed.Move(-x, -y);
+
+    Group *group = nullptr;
+    for (auto &g : groups) {
+      if (g.stable == transformed.stable) {
+        group = &g;
+        break;
+      }
+    }
+    if (group == nullptr) {
+      groups.push_back({transformed.stable, {}});
+      group = &groups.back();
+    }
+
+    std::pair<LifeState, LifeState> interaction = {transformed.active, transformed.inactive};
+    if (std::find(group->activeInactive.begin(), group->activeInactive.end(), interaction) == group->activeInactive.end())
+      group->activeInactive.push_back(interaction);
+  }
+}
+
+// One LifeHistory RLE per template, each ending with '!'. Header lines
+// and '#' comments are ignored.
+inline void Blacklist::AddFile(const std::string &filename) {
+  std::ifstream file(filename);
+  if (!file) {
+    throw std::runtime_error("Could not open blacklist file " + filename);
+  }
+
+  std::string rle;
+  for (std::string line; std::getline(file, line);) {
+    if (line.empty() || line[0] == '#' || line[0] == 'x')
+      continue;
+    rle += line;
+    if (line.find('!') != std::string::npos) {
+      Add(BlacklistTemplate::Parse(rle));
+      rle.clear();
+    }
+  }
+}
+
+inline bool Blacklist::Matches(const LifeState &stable, const LifeState &everActive) const {
+  for (auto &g : groups) {
+    LifeState positions = stable.MatchLive(g.stable);
+    if (positions.IsEmpty())
+      continue;
+
+    for (auto &[active, inactive] : g.activeInactive) {
+      if (!(positions & everActive.MatchLiveAndDead(active, inactive)).IsEmpty())
+        return true;
+    }
+  }
+  return false;
+}
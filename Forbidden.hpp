@@ -0,0 +1,147 @@
+#pragma once
+
+#include "LifeAPI.h"
+#include "LifeStableState.hpp"
+
+struct Forbidden {
+  LifeState mask;
+  LifeState state;
+};
+
+// One orientation of a forbidden pattern that may appear anywhere
+struct ForbiddenTemplate {
+  LifeState live;
+  LifeState dead;
+  std::vector<std::pair<int, int>> cells;
+};
+
+// Forbidden arrangements of stable cells, used as constraints during
+// propagation rather than checked once everything is known: when all
+// but one cell of an occurrence is decided and matches, the remaining
+// cell is forced to the opposite value.
+class ForbiddenMatcher {
+public:
+  std::vector<Forbidden> positional;
+  std::vector<ForbiddenTemplate> templates;
+
+  void AddPositional(const Forbidden &f) { positional.push_back(f); }
+  void AddAnywhere(const Forbidden &f);
+
+  bool IsEmpty() const { return positional.empty() && templates.empty(); }
+
+  PropagateResult PropagateStep(LifeStableState &stable) const;
+  bool Propagate(LifeStableState &stable) const;
+};
+
+inline void ForbiddenMatcher::AddAnywhere(const Forbidden &f) {
+  auto allTransforms = {
+      Identity,           ReflectAcrossXEven,   ReflectAcrossYeqX,
+      ReflectAcrossYEven, ReflectAcrossYeqNegX, Rotate90Even,
+      Rotate270Even,      Rotate180EvenBoth};
+
+  for (auto t : allTransforms) {
+    ForbiddenTemplate transformed = {f.state & f.mask, f.mask & ~f.state, {}};
+    transformed.live.Transform(t);
+    transformed.dead.Transform(t);
+
+    LifeState mask = transformed.live | transformed.dead;
+    auto [x, y, _x2, _y2] = mask.XYBounds();
+    transformed.live.Move(-x, -y);
+    transformed.dead.Move(-x, -y);
+
+    bool seen = false;
+    for (auto &other : templates) {
+      if (other.live == transformed.live && other.dead == transformed.dead) {
+        seen = true;
+        break;
+      }
+    }
+    if (seen)
+      continue;
+
+    transformed.cells = (transformed.live | transformed.dead).OnCells();
+    templates.push_back(transformed);
+  }
+}
+
+inline PropagateResult ForbiddenMatcher::PropagateStep(LifeStableState &stable) const {
+  LifeState knownOn = stable.state & ~stable.unknownStable;
+  LifeState knownOff = ~stable.state & ~stable.unknownStable;
+
+  LifeState forceOn, forceOff;
+
+  for (auto &f : positional) {
+    if (!((stable.state ^ f.state) & f.mask & ~stable.unknownStable).IsEmpty())
+      continue;
+
+    LifeState unknown = f.mask & stable.unknownStable;
+    switch (unknown.GetPop()) {
+    case 0:
+      return {false, false, false};
+    case 1:
+      if ((f.state & unknown).IsEmpty())
+        forceOn |= unknown;
+      else
+        forceOff |= unknown;
+      break;
+    }
+  }
+
+  for (auto &t : templates) {
+    // Positions where no decided cell disagrees with the template
+    LifeState compatible = (knownOn | stable.unknownStable).MatchLive(t.live) &
+                           (knownOff | stable.unknownStable).MatchLive(t.dead);
+    if (compatible.IsEmpty())
+      continue;
+
+    // Count the undecided cells at each position, up to two
+    LifeState one, two;
+    for (auto &cell : t.cells) {
+      LifeState unknown = stable.unknownStable;
+      unknown.Move(-cell.first, -cell.second);
+      two |= one & unknown;
+      one |= unknown;
+    }
+
+    if (!(compatible & ~one).IsEmpty())
+      return {false, false, false};
+
+    LifeState forcing = compatible & one & ~two;
+    if (forcing.IsEmpty())
+      continue;
+
+    for (auto &cell : t.cells) {
+      LifeState forced = forcing;
+      forced.Move(cell.first, cell.second);
+      forced &= stable.unknownStable;
+      if (t.live.Get(cell))
+        forceOff |= forced;
+      else
+        forceOn |= forced;
+    }
+  }
+
+  if (!(forceOn & forceOff).IsEmpty())
+    return {false, false, false};
+
+  LifeState forced = forceOn | forceOff;
+  if (forced.IsEmpty())
+    return {true, false, false};
+
+  stable.state |= forceOn;
+  stable.unknownStable &= ~forced;
+  return {true, true, true};
+}
+
+// Alternate with stable propagation until neither makes progress
+inline bool ForbiddenMatcher::Propagate(LifeStableState &stable) const {
+  while (true) {
+    PropagateResult result = PropagateStep(stable);
+    if (!result.consistent)
+      return false;
+    if (!result.changed)
+      return true;
+    if (!stable.PropagateStable().consistent)
+      return false;
+  }
+}
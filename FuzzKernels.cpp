@@ -0,0 +1,561 @@
+// Checks the bitsliced kernels on random states against slow per-cell
+// versions of the tri-state rules in bitslicing/, and checks that the
+// column and whole-grid variants agree with each other.
+//
+//   ./FuzzKernels [trials] [seed]
+//
+// Trials are deterministic in the seed, so a failure can be rerun.
+
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "LifeAPI.h"
+#include "LifeStableState.hpp"
+#include "LifeUnknownState.hpp"
+
+enum CellState { CellOff, CellOn, CellUnknown };
+
+// ON and UNKNOWN cells of the 3x3 neighbourhood, including the centre
+struct Neighbourhood {
+  unsigned on;
+  unsigned unknown;
+};
+
+Neighbourhood CountCells(const LifeState &on, const LifeState &unknown, int x, int y) {
+  Neighbourhood result = {0, 0};
+  for (int dx = -1; dx <= 1; dx++) {
+    for (int dy = -1; dy <= 1; dy++) {
+      int nx = (x + dx + N) % N;
+      int ny = (y + dy + N) % N;
+      result.on += on.Get(nx, ny);
+      result.unknown += unknown.Get(nx, ny);
+    }
+  }
+  return result;
+}
+
+CellState Centre(const LifeState &on, const LifeState &unknown, int x, int y) {
+  if (unknown.Get(x, y))
+    return CellUnknown;
+  return on.Get(x, y) ? CellOn : CellOff;
+}
+
+bool LifeRule(bool on, unsigned neighbours) {
+  return neighbours == 3 || (on && neighbours == 2);
+}
+
+// The counts the search keeps alongside a stable state. ON counts are
+// kept mod 8, which the generator never reaches.
+void SetCounts(LifeStableState &stable) {
+  for (int x = 0; x < N; x++) {
+    for (int y = 0; y < N; y++) {
+      auto counts = CountCells(stable.state, stable.unknownStable, x, y);
+      stable.state2.SetCellUnsafe(x, y, (counts.on >> 2) & 1);
+      stable.state1.SetCellUnsafe(x, y, (counts.on >> 1) & 1);
+      stable.state0.SetCellUnsafe(x, y, counts.on & 1);
+      stable.unknown3.SetCellUnsafe(x, y, (counts.unknown >> 3) & 1);
+      stable.unknown2.SetCellUnsafe(x, y, (counts.unknown >> 2) & 1);
+      stable.unknown1.SetCellUnsafe(x, y, (counts.unknown >> 1) & 1);
+      stable.unknown0.SetCellUnsafe(x, y, counts.unknown & 1);
+    }
+  }
+}
+
+// The stable rules for one cell, from bitslicing/stable_count.py and
+// stable_signal.py, and the glancing rules in PropagateStableStep
+struct StableRule {
+  bool abort;
+  bool setOff;
+  bool setOn;
+  bool signalOff; // Every UNKNOWN cell in the neighbourhood is OFF
+  bool signalOn;
+};
+
+StableRule StableRuleAt(const LifeStableState &stable, int x, int y) {
+  StableRule rule = {};
+  CellState centre = Centre(stable.state, stable.unknownStable, x, y);
+  auto counts = CountCells(stable.state, stable.unknownStable, x, y);
+
+  // Not including the centre
+  unsigned on = counts.on - (centre == CellOn);
+  unsigned unknown = counts.unknown - (centre == CellUnknown);
+
+  bool onPossible = on <= 3 && on + unknown >= 2;
+  bool offPossible = !(on == 3 && unknown == 0);
+
+  if (centre == CellUnknown) {
+    rule.setOff = !onPossible;
+    rule.setOn = !offPossible;
+  } else {
+    rule.abort = centre == CellOn ? !onPossible : !offPossible;
+
+    // Signal when only one of the counts in range keeps the centre stable
+    unsigned allowed = 0;
+    unsigned only = 0;
+    for (unsigned k = on; k <= on + unknown; k++) {
+      if (LifeRule(centre == CellOn, k) == (centre == CellOn)) {
+        allowed++;
+        only = k;
+      }
+    }
+    if (unknown > 0 && allowed == 1) {
+      rule.signalOff = only == on;
+      rule.signalOn = only == on + unknown;
+    }
+  }
+
+  if (stable.glanced.Get(x, y)) {
+    rule.abort |= centre == CellOn || counts.on >= 2;
+    rule.signalOff |= counts.on == 1 && counts.unknown > 0;
+  }
+  if (stable.glancedON.Get(x, y)) {
+    rule.abort |= centre == CellOn || counts.on + counts.unknown < 2;
+    rule.signalOn |= counts.on + counts.unknown == 2 && counts.unknown > 0;
+  }
+
+  return rule;
+}
+
+struct StableStepReference {
+  bool abort;
+  bool conflict; // Some cell is forced both ways, the kernels may differ
+  LifeState state;
+  LifeState unknownStable;
+};
+
+// One step of the stable rules at the cells in `columns`
+StableStepReference StableStep(const LifeStableState &stable, uint64_t columns) {
+  LifeState forcedOn, forcedOff;
+  bool abort = false;
+
+  for (int x = 0; x < N; x++) {
+    if (!(columns & (1ULL << x)))
+      continue;
+    for (int y = 0; y < N; y++) {
+      StableRule rule = StableRuleAt(stable, x, y);
+      abort |= rule.abort;
+      if (rule.setOn)
+        forcedOn.Set(x, y);
+      if (rule.setOff)
+        forcedOff.Set(x, y);
+      if (rule.signalOn)
+        forcedOn |= LifeState::CellZOI({x, y});
+      if (rule.signalOff)
+        forcedOff |= LifeState::CellZOI({x, y});
+    }
+  }
+  forcedOn &= stable.unknownStable;
+  forcedOff &= stable.unknownStable;
+
+  return {abort, !(forcedOn & forcedOff).IsEmpty(), stable.state | forcedOn,
+          stable.unknownStable & ~forcedOn & ~forcedOff};
+}
+
+// The tri-state step of one cell, from bitslicing/unknown_step.py
+struct UncertainCell {
+  bool on;
+  bool unknown;
+};
+
+UncertainCell UncertainStepAt(const LifeUnknownState &current, int x, int y) {
+  CellState centre = Centre(current.state, current.unknown, x, y);
+  auto counts = CountCells(current.state, current.unknown, x, y);
+  unsigned on = counts.on - (centre == CellOn);
+  unsigned unknown = counts.unknown - (centre == CellUnknown);
+
+  bool maybeOn = false;
+  bool maybeOff = false;
+  for (unsigned k = on; k <= on + unknown; k++) {
+    for (bool centreOn : {false, true}) {
+      if (centre != CellUnknown && centreOn != (centre == CellOn))
+        continue;
+      if (LifeRule(centreOn, k))
+        maybeOn = true;
+      else
+        maybeOff = true;
+    }
+  }
+  return {maybeOn && !maybeOff, maybeOn && maybeOff};
+}
+
+// Whether the neighbourhood of the cell is exactly as in `stable`, so
+// that an UNKNOWN result can be taken from the stable state instead
+bool MatchesStable(const LifeUnknownState &current, const LifeStableState &stable, int x, int y) {
+  auto counts = CountCells(current.state, current.unknown, x, y);
+  auto stableCounts = CountCells(stable.state, stable.unknownStable, x, y);
+  return current.state.Get(x, y) == stable.state.Get(x, y) &&
+         current.unknownStable.Get(x, y) == stable.unknownStable.Get(x, y) &&
+         counts.on == stableCounts.on && counts.on < 8 &&
+         counts.unknown == stableCounts.unknown;
+}
+
+LifeUnknownState UncertainStepMaintainingReference(const LifeUnknownState &current, const LifeStableState &stable) {
+  LifeUnknownState result;
+  for (int x = 0; x < N; x++) {
+    for (int y = 0; y < N; y++) {
+      UncertainCell next = UncertainStepAt(current, x, y);
+      auto counts = CountCells(current.state, current.unknown, x, y);
+      unsigned stableOn = CountCells(stable.state, stable.unknownStable, x, y).on;
+
+      // An OFF cell that might only be glancing at its one ON neighbour
+      bool quiet = next.unknown && Centre(current.state, current.unknown, x, y) == CellOff &&
+                   stableOn == 0 && counts.on < 2;
+      result.glanceableUnknown.SetCellUnsafe(x, y, quiet && counts.on == 1 && counts.unknown > 0);
+      if (quiet && stable.glanced.Get(x, y))
+        next.unknown = false;
+
+      bool restore = next.unknown && MatchesStable(current, stable, x, y);
+      if (restore) {
+        result.state.SetCellUnsafe(x, y, stable.state.Get(x, y));
+        result.unknown.SetCellUnsafe(x, y, stable.unknownStable.Get(x, y));
+        result.unknownStable.SetCellUnsafe(x, y, stable.unknownStable.Get(x, y));
+      } else {
+        result.state.SetCellUnsafe(x, y, next.on);
+        result.unknown.SetCellUnsafe(x, y, next.unknown);
+      }
+    }
+  }
+  return result;
+}
+
+// A stable state that is mostly OFF, with a random patch of ON and
+// UNKNOWN cells. No neighbourhood has more than 6 ON cells, the most
+// the espresso tables cover.
+LifeStableState RandomStable(std::mt19937_64 &rng) {
+  std::uniform_int_distribution<int> position(0, N - 1);
+  std::uniform_int_distribution<int> size(3, 24);
+  std::uniform_real_distribution<double> unit(0, 1);
+
+  int x0 = position(rng), y0 = position(rng);
+  int width = size(rng), height = size(rng);
+  double unknownDensity = unit(rng);
+  double onDensity = 0.5 * unit(rng);
+  double glanceDensity = unit(rng) < 0.5 ? 0 : 0.05;
+
+  LifeStableState stable = {};
+  for (int dx = 0; dx < width; dx++) {
+    for (int dy = 0; dy < height; dy++) {
+      int x = (x0 + dx) % N, y = (y0 + dy) % N;
+      double r = unit(rng);
+      if (r < unknownDensity)
+        stable.unknownStable.Set(x, y);
+      else if (r < unknownDensity + (1 - unknownDensity) * onDensity)
+        stable.state.Set(x, y);
+
+      // Usually UNKNOWN when marked, but later steps may have set them
+      if (unit(rng) < glanceDensity)
+        (unit(rng) < 0.5 ? stable.glanced : stable.glancedON).Set(x, y);
+    }
+  }
+
+  for (bool crowded = true; crowded;) {
+    crowded = false;
+    for (int x = 0; x < N; x++) {
+      for (int y = 0; y < N; y++) {
+        if (CountCells(stable.state, stable.unknownStable, x, y).on > 6) {
+          stable.state.Erase((stable.state & LifeState::CellZOI({x, y})).FirstOn());
+          crowded = true;
+        }
+      }
+    }
+  }
+
+  SetCounts(stable);
+  stable.stateZOI = stable.state.ZOI();
+  return stable;
+}
+
+// The stable state with some cells of a patch of it changed
+LifeUnknownState RandomCurrent(const LifeStableState &stable, std::mt19937_64 &rng) {
+  std::uniform_int_distribution<int> position(0, N - 1);
+  std::uniform_int_distribution<int> size(1, 16);
+  std::uniform_real_distribution<double> unit(0, 1);
+
+  LifeUnknownState current = {stable.state, stable.unknownStable, stable.unknownStable, LifeState()};
+
+  int x0 = position(rng), y0 = position(rng);
+  int width = size(rng), height = size(rng);
+  double changeDensity = unit(rng);
+  for (int dx = 0; dx < width; dx++) {
+    for (int dy = 0; dy < height; dy++) {
+      int x = (x0 + dx) % N, y = (y0 + dy) % N;
+      if (unit(rng) >= changeDensity)
+        continue;
+      current.unknownStable.Erase(x, y);
+      double r = unit(rng);
+      current.state.SetCellUnsafe(x, y, r < 0.4);
+      current.unknown.SetCellUnsafe(x, y, r >= 0.7);
+    }
+  }
+  return current;
+}
+
+// TestUnknown as it was, copying the whole state for each value
+PropagateResult TestUnknownReference(LifeStableState &stable, std::pair<int, int> cell) {
+  LifeStableState onSearch = stable;
+  onSearch.state.SetCell(cell, true);
+  onSearch.unknownStable.Erase(cell);
+  auto onResult = onSearch.PropagateColumn(cell.first);
+
+  LifeStableState offSearch = stable;
+  offSearch.state.SetCell(cell, false);
+  offSearch.unknownStable.Erase(cell);
+  auto offResult = offSearch.PropagateColumn(cell.first);
+
+  if (!onResult.consistent && !offResult.consistent)
+    return {false, false, false};
+  if (!offResult.consistent) {
+    stable = onSearch;
+    return {true, true, true};
+  }
+  if (!onResult.consistent) {
+    stable = offSearch;
+    return {true, true, true};
+  }
+  if (onResult.changed && offResult.changed) {
+    LifeState agreement = stable.unknownStable & ~onSearch.unknownStable & ~offSearch.unknownStable &
+                          ~(onSearch.state ^ offSearch.state);
+    stable.state |= agreement & onSearch.state;
+    stable.unknownStable &= ~agreement;
+    return {true, !agreement.IsEmpty(), !agreement.IsEmpty()};
+  }
+  return {true, false, false};
+}
+
+class Checker {
+public:
+  unsigned failures = 0;
+
+  void Check(bool ok, const std::string &kernel, uint64_t trial, const std::string &what,
+             const LifeStableState &stable);
+  void Check(const LifeState &actual, const LifeState &expected, const std::string &kernel,
+             uint64_t trial, const std::string &what, const LifeStableState &stable);
+};
+
+void Checker::Check(bool ok, const std::string &kernel, uint64_t trial, const std::string &what,
+                    const LifeStableState &stable) {
+  if (ok)
+    return;
+  failures++;
+  if (failures > 10)
+    return;
+  std::cout << kernel << " trial " << trial << ": " << what << std::endl;
+  std::cout << "  stable ON: " << stable.state.RLE() << std::endl;
+  std::cout << "  stable UNKNOWN: " << stable.unknownStable.RLE() << std::endl;
+}
+
+void Checker::Check(const LifeState &actual, const LifeState &expected, const std::string &kernel,
+                    uint64_t trial, const std::string &what, const LifeStableState &stable) {
+  if (actual == expected)
+    return;
+  auto cell = (actual ^ expected).FirstOn();
+  Check(false, kernel, trial,
+        what + " differs at (" + std::to_string(cell.first) + ", " + std::to_string(cell.second) + ")",
+        stable);
+}
+
+// Reference outcomes seen, to show the trials aren't all trivial
+struct Coverage {
+  unsigned aborts = 0;
+  unsigned conflicts = 0;
+  unsigned checked = 0;
+  unsigned changed = 0;
+};
+
+// One of the given columns, or any if there are none
+int RandomColumn(uint64_t columns, std::mt19937_64 &rng) {
+  if (columns == 0)
+    columns = ~0ULL;
+  int skip = std::uniform_int_distribution<int>(0, __builtin_popcountll(columns) - 1)(rng);
+  for (; skip > 0; skip--)
+    columns &= columns - 1;
+  return __builtin_ctzll(columns);
+}
+
+uint64_t ColumnWindow(int column, int from, int to) {
+  uint64_t result = 0;
+  for (int i = from; i <= to; i++)
+    result |= 1ULL << ((column + i + N) % N);
+  return result;
+}
+
+int main(int argc, char *argv[]) {
+  uint64_t trials = argc > 1 ? std::stoull(argv[1]) : 2000;
+  uint64_t seed = argc > 2 ? std::stoull(argv[2]) : 0;
+
+  Checker checker;
+  Coverage columnCoverage, stableCoverage;
+
+  for (uint64_t trial = 0; trial < trials; trial++) {
+    std::mt19937_64 rng(HASH::hash64(seed, trial));
+    LifeStableState stable = RandomStable(rng);
+    LifeUnknownState current = RandomCurrent(stable, rng);
+    int column = RandomColumn(stable.unknownStable.PopulatedColumns(), rng);
+
+    // PropagateColumnStep
+    {
+      StableStepReference expected = StableStep(stable, ColumnWindow(column, -1, 2));
+      LifeStableState actual = stable;
+      PropagateResult result = actual.PropagateColumnStep(column);
+
+      if (expected.abort) {
+        columnCoverage.aborts++;
+        checker.Check(!result.consistent, "PropagateColumnStep", trial, "missed an inconsistency", stable);
+      } else if (expected.conflict) {
+        columnCoverage.conflicts++;
+      } else {
+        columnCoverage.checked++;
+        checker.Check(result.consistent, "PropagateColumnStep", trial, "inconsistent", stable);
+        if (result.consistent) {
+          LifeState changes = stable.unknownStable ^ expected.unknownStable;
+          columnCoverage.changed += !changes.IsEmpty();
+          checker.Check(actual.state, expected.state, "PropagateColumnStep", trial, "state", stable);
+          checker.Check(actual.unknownStable, expected.unknownStable, "PropagateColumnStep", trial, "unknownStable", stable);
+          checker.Check(result.changed == !changes.IsEmpty(), "PropagateColumnStep", trial, "changed", stable);
+          bool edgesChanged = (changes.PopulatedColumns() & (ColumnWindow(column, -2, -1) | ColumnWindow(column, 2, 3))) != 0;
+          checker.Check(result.edgesChanged == edgesChanged, "PropagateColumnStep", trial, "edgesChanged", stable);
+        }
+      }
+    }
+
+    // PropagateStableStep
+    {
+      StableStepReference expected = StableStep(stable, ~0ULL);
+      LifeStableState actual = stable;
+      PropagateResult result = actual.PropagateStableStep();
+
+      if (expected.abort) {
+        stableCoverage.aborts++;
+        checker.Check(!result.consistent, "PropagateStableStep", trial, "missed an inconsistency", stable);
+      } else if (expected.conflict) {
+        stableCoverage.conflicts++;
+      } else {
+        stableCoverage.checked++;
+        checker.Check(result.consistent, "PropagateStableStep", trial, "inconsistent", stable);
+        if (result.consistent) {
+          bool changed = stable.unknownStable != expected.unknownStable;
+          stableCoverage.changed += changed;
+          checker.Check(actual.state, expected.state, "PropagateStableStep", trial, "state", stable);
+          checker.Check(actual.unknownStable, expected.unknownStable, "PropagateStableStep", trial, "unknownStable", stable);
+          checker.Check(result.changed == changed, "PropagateStableStep", trial, "changed", stable);
+        }
+      }
+    }
+
+    // Propagating a column first mustn't change where PropagateStable ends up
+    {
+      LifeStableState direct = stable;
+      PropagateResult directResult = direct.PropagateStable();
+      LifeStableState viaColumn = stable;
+      PropagateResult columnResult = viaColumn.PropagateColumn(column);
+      if (columnResult.consistent)
+        columnResult = viaColumn.PropagateStable();
+
+      checker.Check(directResult.consistent == columnResult.consistent, "PropagateColumn", trial,
+                    "disagrees with PropagateStable on consistency", stable);
+      if (directResult.consistent && columnResult.consistent) {
+        checker.Check(viaColumn.state, direct.state, "PropagateColumn", trial, "state after PropagateStable", stable);
+        checker.Check(viaColumn.unknownStable, direct.unknownStable, "PropagateColumn", trial, "unknownStable after PropagateStable", stable);
+      }
+    }
+
+    // A batch of probes is the same as PropagateColumn on each one
+    {
+      LifeState probes = ProbeBatch(stable.unknownStable);
+      uint64_t probeColumns = probes.PopulatedColumns();
+      LifeState values;
+      for (int i = 0; i < N; i++)
+        values[i] = rng();
+      LifeStableState placed = stable;
+      placed.state |= probes & values;
+      placed.unknownStable &= ~probes;
+
+      LifeStableState batch = placed;
+      uint64_t failed = batch.PropagateProbes(probeColumns);
+      for (uint64_t remaining = probeColumns; remaining != 0; remaining &= remaining - 1) {
+        int probe = __builtin_ctzll(remaining);
+        LifeStableState single = placed;
+        PropagateResult result = single.PropagateColumn(probe);
+
+        bool probeFailed = (failed >> probe) & 1;
+        checker.Check(probeFailed == !result.consistent, "PropagateProbes", trial,
+                      "disagrees with PropagateColumn on consistency at column " + std::to_string(probe), stable);
+        if (result.consistent && !probeFailed) {
+          LifeState window = ColumnMask(SmearColumns(1ULL << probe, 2, 3));
+          checker.Check(batch.state & window, single.state & window, "PropagateProbes", trial, "state", stable);
+          checker.Check(batch.unknownStable & window, single.unknownStable & window, "PropagateProbes", trial, "unknownStable", stable);
+        }
+      }
+    }
+
+    // TestUnknown only saves and restores the columns around the cell
+    if (!stable.unknownStable.IsEmpty()) {
+      auto cell = (stable.unknownStable & ColumnMask(1ULL << RandomColumn(stable.unknownStable.PopulatedColumns(), rng))).FirstOn();
+      LifeStableState expected = stable;
+      PropagateResult expectedResult = TestUnknownReference(expected, cell);
+      LifeStableState actual = stable;
+      PropagateResult result = actual.TestUnknown(cell);
+
+      checker.Check(result.consistent == expectedResult.consistent, "TestUnknown", trial, "consistent", stable);
+      if (result.consistent && expectedResult.consistent) {
+        checker.Check(actual.state, expected.state, "TestUnknown", trial, "state", stable);
+        checker.Check(actual.unknownStable, expected.unknownStable, "TestUnknown", trial, "unknownStable", stable);
+        checker.Check(actual.stateZOI, expected.stateZOI, "TestUnknown", trial, "stateZOI", stable);
+        checker.Check(result.changed == expectedResult.changed, "TestUnknown", trial, "changed", stable);
+      }
+    }
+
+    // UncertainStepMaintaining
+    LifeUnknownState expected = UncertainStepMaintainingReference(current, stable);
+    LifeUnknownState actual = current.UncertainStepMaintaining(stable);
+    checker.Check(actual.state, expected.state, "UncertainStepMaintaining", trial, "state", stable);
+    checker.Check(actual.unknown, expected.unknown, "UncertainStepMaintaining", trial, "unknown", stable);
+    checker.Check(actual.unknownStable, expected.unknownStable, "UncertainStepMaintaining", trial, "unknownStable", stable);
+    checker.Check(actual.glanceableUnknown, expected.glanceableUnknown, "UncertainStepMaintaining", trial, "glanceableUnknown", stable);
+
+    // UncertainStepMaintainingColumns only writes its columns, and
+    // agrees with the whole grid there
+    {
+      uint64_t columns = rng();
+      LifeUnknownState before = {LifeState::RandomState(), LifeState::RandomState(),
+                                 LifeState::RandomState(), LifeState::RandomState()};
+      LifeUnknownState partial = before;
+      current.UncertainStepMaintainingColumns(stable, columns, partial);
+
+      LifeState mask = ColumnMask(columns);
+      auto merged = [&](const LifeState &inside, const LifeState &outside) {
+        return (inside & mask) | (outside & ~mask);
+      };
+      checker.Check(partial.state, merged(actual.state, before.state), "UncertainStepMaintainingColumns", trial, "state", stable);
+      checker.Check(partial.unknown, merged(actual.unknown, before.unknown), "UncertainStepMaintainingColumns", trial, "unknown", stable);
+      checker.Check(partial.unknownStable, merged(actual.unknownStable, before.unknownStable), "UncertainStepMaintainingColumns", trial, "unknownStable", stable);
+      checker.Check(partial.glanceableUnknown, merged(actual.glanceableUnknown, before.glanceableUnknown), "UncertainStepMaintainingColumns", trial, "glanceableUnknown", stable);
+    }
+
+    // UncertainStepColumn, which has no glancing
+    {
+      auto [next, unknown, unknownStable] = current.UncertainStepColumn(stable, column);
+      for (int y = 0; y < N; y++) {
+        UncertainCell cell = UncertainStepAt(current, column, y);
+        bool cellUnknownStable = cell.unknown && MatchesStable(current, stable, column, y);
+        bool ok = ((next >> y) & 1) == cell.on && ((unknown >> y) & 1) == cell.unknown &&
+                  ((unknownStable >> y) & 1) == cellUnknownStable;
+        checker.Check(ok, "UncertainStepColumn", trial, "differs at (" + std::to_string(column) + ", " + std::to_string(y) + ")", stable);
+      }
+    }
+  }
+
+  std::cout << trials << " trials, seed " << seed << std::endl;
+  std::cout << "PropagateColumnStep: " << columnCoverage.aborts << " inconsistent, " << columnCoverage.conflicts
+            << " conflicting, " << columnCoverage.checked << " checked (" << columnCoverage.changed << " changed)" << std::endl;
+  std::cout << "PropagateStableStep: " << stableCoverage.aborts << " inconsistent, " << stableCoverage.conflicts
+            << " conflicting, " << stableCoverage.checked << " checked (" << stableCoverage.changed << " changed)" << std::endl;
+
+  if (checker.failures > 0) {
+    std::cout << checker.failures << " failures" << std::endl;
+    return 1;
+  }
+  std::cout << "All kernels agree" << std::endl;
+  return 0;
+}
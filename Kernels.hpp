@@ -0,0 +1,48 @@
+#pragma once
+
+// Generated by bitslicing/kernels.py, do not edit. Regenerate with
+// `make Kernels.hpp`.
+
+#include <cstdint>
+
+// Each kernel ORs its results into the outputs, for 64 cells at once.
+// Counts are of the 3x3 neighbourhood including the centre, and must
+// saturate: on2..on0 at 7 and unk1..unk0 at 3.
+
+// Whether a cell of a stable state forces UNKNOWN cells: setting the
+// centre (only meaningful when it is UNKNOWN), or signalling every
+// UNKNOWN cell of the neighbourhood (only when there is one). abort
+// means no choice of the UNKNOWN cells keeps the centre stable.
+constexpr inline void StableRuleKernel(uint64_t stateunk, uint64_t stateon, uint64_t on2, uint64_t on1, uint64_t on0, uint64_t unk1, uint64_t unk0,
+                                       uint64_t &set_off, uint64_t &set_on, uint64_t &signal_off, uint64_t &signal_on, uint64_t &abort) {
+  set_off |= on2;
+  set_off |= (~on1) & (~on0) & (~unk0);
+  set_off |= (~on1) & (~unk1);
+  set_on |= on1 & on0 & (~unk1);
+  signal_off |= (~stateunk) & (~stateon) & (~on2) & on1 & (~on0) & (~unk1);
+  signal_off |= stateon & on2;
+  signal_on |= (~stateunk) & (~stateon) & on1 & on0 & (~unk1);
+  signal_on |= stateon & (~on2) & (~on1) & (~unk0);
+  signal_on |= stateon & (~on2) & (~on0) & (~unk1);
+  abort |= stateon & (~on2) & (~on1) & (~unk1);
+  abort |= stateon & on2 & on1;
+  abort |= stateon & (~on2) & (~on0) & (~unk1) & (~unk0);
+  abort |= stateon & on2 & on0;
+  abort |= (~stateon) & on1 & on0 & (~unk1) & (~unk0);
+}
+
+// The next generation of a cell, ON, OFF or UNKNOWN
+constexpr inline void UncertainStepKernel(uint64_t stateunk, uint64_t stateon, uint64_t on2, uint64_t on1, uint64_t on0, uint64_t unk1, uint64_t unk0,
+                                          uint64_t &next_on, uint64_t &unknown) {
+  next_on |= stateunk & (~on2) & on1 & on0 & (~unk1);
+  next_on |= stateon & (~on2) & on1 & on0 & (~unk1);
+  next_on |= stateon & (~on1) & (~on0) & (~unk1) & (~unk0);
+  next_on |= (~on2) & on1 & on0 & (~unk1) & (~unk0);
+  unknown |= (~stateunk) & (~stateon) & (~on2) & on1 & unk0;
+  unknown |= stateon & (~on1) & (~on0) & unk1;
+  unknown |= stateon & (~on1) & (~on0) & unk0;
+  unknown |= (~on2) & on1 & (~on0) & unk0;
+  unknown |= (~on2) & on1 & unk1;
+  unknown |= (~on2) & on0 & unk1;
+  unknown |= (~on2) & unk1 & unk0;
+}
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <array>
+#include <charconv>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,6 +16,7 @@
 #include <vector>
 #include <iostream>
 #include <sstream>
+#include <string_view>
 #include <random>
 
 #ifdef __AVX2__
@@ -185,15 +187,15 @@ constexpr uint64_t convolve_uint64_t(uint64_t x, uint64_t y) {
 }
 
 namespace PRNG {
-  std::random_device rd;
-  std::mt19937_64 e2(rd());
-  std::uniform_int_distribution<uint64_t> dist(std::llround(std::pow(2,61)), std::llround(std::pow(2,62)));
+  inline std::random_device rd;
+  inline std::mt19937_64 e2(rd());
+  inline std::uniform_int_distribution<uint64_t> dist(std::llround(std::pow(2,61)), std::llround(std::pow(2,62)));
 // Public domain PRNG by Sebastian Vigna 2014, see http://xorshift.di.unimi.it
 
-uint64_t s[16] = {0x12345678};
-int p = 0;
+inline uint64_t s[16] = {0x12345678};
+inline int p = 0;
 
-uint64_t rand64() {
+inline uint64_t rand64() {
   uint64_t s0 = s[p];
   uint64_t s1 = s[p = (p + 1) & 15];
   s1 ^= s1 << 31; // a
@@ -354,6 +356,19 @@ public:
     return result;
   }
 
+  // Like GetHash, but only hashing the populated columns, with their
+  // positions
+  uint64_t GetSparseHash() const {
+    uint64_t result = 0;
+
+    for (uint64_t columns = PopulatedColumns(); columns != 0; columns &= columns - 1) {
+      int i = __builtin_ctzll(columns);
+      result = HASH::hash64(HASH::hash64(result, i), state[i]);
+    }
+
+    return result;
+  }
+
   uint64_t GetOctoHash() const {
     uint64_t result = 0;
 
@@ -1233,7 +1248,7 @@ public:
 
 };
 
-void LifeState::Step() {
+inline void LifeState::Step() {
   uint64_t tempxor[N];
   uint64_t tempand[N];
 
@@ -1276,7 +1291,7 @@ void LifeState::Step() {
   //
 }
 
-void LifeState::Transform(SymmetryTransform transf) {
+inline void LifeState::Transform(SymmetryTransform transf) {
   switch (transf) {
   case Identity:
     break;
@@ -1344,7 +1359,7 @@ void LifeState::Transform(SymmetryTransform transf) {
   }
 }
 
-void LifeState::Print() const {
+inline void LifeState::Print() const {
   for (int j = 0; j < 64; j++) {
     for (int i = 0; i < N; i++) {
       if (GetCell(i - (N/2), j - 32) == 0) {
@@ -1374,47 +1389,155 @@ void LifeState::Print() const {
   printf("\n\n\n\n\n\n");
 }
 
-LifeState LifeState::Parse(const char *rle) {
-  LifeState result;
-
-  char ch;
-  int cnt, i, j;
-  int x, y;
-  x = 0;
-  y = 0;
-  cnt = 0;
-
-  i = 0;
+// Run-length encoding shared by all the state types. A cell's value is
+// the set of layers it is on in, as a bitmask, and is written as
+// `table[value]`. Cells are fed in a row at a time, and runs of
+// identical cells are merged.
+class RLEWriter {
+public:
+  RLEWriter(const char *intable) : table{intable}, eolCount{0}, runValue{0}, runLength{0} {
+    result.reserve(256);
+  }
+
+  // A row of 64 cells, one word per layer. Runs are found with ctz on
+  // the places where adjacent cells differ.
+  template <size_t Layers>
+  void Row(const std::array<uint64_t, Layers> &row) {
+    uint64_t changes = 0;
+    for (unsigned l = 0; l < Layers; l++)
+      changes |= row[l] ^ (row[l] << 1);
+    changes &= ~1ULL;
+
+    unsigned start = 0;
+    while (true) {
+      unsigned end = changes == 0 ? 64 : __builtin_ctzll(changes);
+      unsigned value = 0;
+      for (unsigned l = 0; l < Layers; l++)
+        value |= ((row[l] >> start) & 1) << l;
+      Cells(value, end - start);
+      if (changes == 0)
+        break;
+      changes &= changes - 1;
+      start = end;
+    }
+  }
 
-  while ((ch = rle[i]) != '\0') {
+  void Cells(unsigned value, unsigned count) {
+    if (value != runValue) {
+      // Only flush linefeeds once we find a live cell
+      if (value != 0 && eolCount > 0) {
+        Count(eolCount);
+        result += '$';
+        eolCount = 0;
+      }
+      Flush();
+      runValue = value;
+    }
+    runLength += count;
+  }
 
-    if (ch >= '0' && ch <= '9') {
-      cnt *= 10;
-      cnt += (ch - '0');
-    } else if (ch == 'o') {
+  // A trailing run of dead cells is dropped
+  void EndRow() {
+    if (runValue != 0)
+      Flush();
+    runValue = 0;
+    runLength = 0;
+    eolCount++;
+  }
 
-      if (cnt == 0)
-        cnt = 1;
+  void EmptyRows(unsigned count) { eolCount += count; }
 
-      for (j = 0; j < cnt; j++) {
-        result.SetCell(x, y, 1);
-        x++;
-      }
+  std::string Finish() {
+    if (eolCount > 0) {
+      Count(eolCount);
+      result += '$';
+      eolCount = 0;
+    }
+    return std::move(result);
+  }
 
-      cnt = 0;
-    } else if (ch == 'b') {
-      if (cnt == 0)
-        cnt = 1;
+private:
+  const char *table;
+  std::string result;
+  unsigned eolCount;
+  unsigned runValue;
+  unsigned runLength;
+
+  void Count(unsigned count) {
+    if (count <= 1)
+      return;
+    char digits[16];
+    auto [end, _] = std::to_chars(digits, digits + sizeof(digits), count);
+    result.append(digits, end);
+  }
+
+  void Flush() {
+    if (runLength == 0)
+      return;
+    Count(runLength);
+    result += table[runValue];
+    runLength = 0;
+  }
+};
 
-      x += cnt;
-      cnt = 0;
+// The RLE of the stacked layers, over the whole torus with (0, 0) in the
+// middle. Each layer is transposed so that a row is a single word.
+template <unsigned Layers>
+std::string LayeredRLE(const std::array<LifeState, Layers> &layers, const char *table) {
+  std::array<LifeState, Layers> rows;
+  uint64_t populatedRows = 0;
+  for (unsigned l = 0; l < Layers; l++) {
+    rows[l] = LifeState(layers[l]).Moved(N / 2, 32);
+    rows[l].Transpose(false);
+    for (unsigned j = 0; j < 64; j++)
+      populatedRows |= (uint64_t)(rows[l][j] != 0) << j;
+  }
+
+  RLEWriter writer(table);
+  unsigned j = 0;
+  while (populatedRows != 0) {
+    unsigned next = __builtin_ctzll(populatedRows);
+    writer.EmptyRows(next - j);
+
+    std::array<uint64_t, Layers> row;
+    for (unsigned l = 0; l < Layers; l++)
+      row[l] = rows[l][next];
+    writer.Row(row);
+    writer.EndRow();
+
+    populatedRows &= populatedRows - 1;
+    j = next + 1;
+  }
+  writer.EmptyRows(64 - j);
+  return writer.Finish();
+}
 
+// The inverse of LayeredRLE, except that the pattern starts at (0, 0).
+// `charLayers` gives the layers a cell character sets, or -1 if the
+// character makes the RLE invalid. Cells are ORed into `layers`, which
+// are still filled in up to the point where the RLE turned out to be
+// invalid.
+template <unsigned Layers, typename CharLayers>
+bool ParseLayeredRLE(std::string_view rle, CharLayers charLayers, std::array<LifeState, Layers> &layers) {
+  std::array<LifeState, Layers> rows;
+  bool valid = true;
+
+  unsigned cnt = 0;
+  unsigned x = 0;
+  unsigned y = 0;
+
+  for (char const ch : rle) {
+    if (ch >= '0' && ch <= '9') {
+      cnt *= 10;
+      cnt += (ch - '0');
     } else if (ch == '$') {
       if (cnt == 0)
         cnt = 1;
 
-      if (cnt == 129)
-        return LifeState();
+      if (cnt == 129) {
+        valid = false;
+        break;
+      }
 
       y += cnt;
       x = 0;
@@ -1422,81 +1545,55 @@ LifeState LifeState::Parse(const char *rle) {
     } else if (ch == '!') {
       break;
     } else {
-      return LifeState();
-    }
-
-    i++;
-  }
-
-  return result;
-}
-
-std::string LifeState::RLE() const {
-  std::stringstream result;
-
-  unsigned eol_count = 0;
-
-  for (unsigned j = 0; j < 64; j++) {
-    bool last_val = GetCell(0 - (N/2), j - 32) == 1;
-    unsigned run_count = 0;
-
-    for (unsigned i = 0; i < N; i++) {
-      bool val = GetCell(i - (N/2), j - 32) == 1;
-
-      // Flush linefeeds if we find a live cell
-      if (val && eol_count > 0) {
-        if (eol_count > 1)
-          result << eol_count;
-
-        result << "$";
-
-        eol_count = 0;
+      int value = charLayers(ch);
+      if (value < 0) {
+        valid = false;
+        break;
       }
+      if (cnt == 0)
+        cnt = 1;
 
-      // Flush current run if val changes
-      if (val == !last_val) {
-        if (run_count > 1)
-          result << run_count;
-
-        if (last_val == 1)
-          result << "o";
-        else
-          result << "b";
-
-        run_count = 0;
+      if (value != 0) {
+        uint64_t run = cnt >= 64 ? ~0ULL : RotateLeft((1ULL << cnt) - 1, x % 64);
+        for (unsigned l = 0; l < Layers; l++)
+          if (value & (1 << l))
+            rows[l][y % 64] |= run;
       }
 
-      run_count++;
-      last_val = val;
-    }
-
-    // Flush run of live cells at end of line
-    if (last_val) {
-      if (run_count > 1)
-        result << run_count;
-
-      result << "o";
-
-      run_count = 0;
+      x += cnt;
+      cnt = 0;
     }
-
-    eol_count++;
   }
 
-  // Flush trailing linefeeds
-  if (eol_count > 0) {
-    if (eol_count > 1)
-      result << eol_count;
-
-    result << "$";
-
-    eol_count = 0;
+  for (unsigned l = 0; l < Layers; l++) {
+    rows[l].Transpose(false);
+    layers[l] |= rows[l];
   }
+  return valid;
+}
+
+inline LifeState LifeState::Parse(const char *rle) {
+  std::array<LifeState, 1> result;
+  auto charLayers = [](char ch) {
+    switch (ch) {
+    case 'o':
+      return 1;
+    case 'b':
+      return 0;
+    default:
+      return -1;
+    }
+  };
+  if (!ParseLayeredRLE<1>(rle, charLayers, result))
+    return LifeState();
+  return result[0];
+}
 
-  return result.str();
+inline std::string LifeState::RLE() const {
+  return LayeredRLE<1>({*this}, "bo");
 }
 
-std::pair<int, int> LifeState::FindSetNeighbour(std::pair<int, int> cell) const {
+inline std::pair<int, int> LifeState::FindSetNeighbour(std::pair<int, int> cell) const {
   // This could obviously be done faster by extracting the result
   // directly from the columns, but this is probably good enough for now
   const std::array<std::pair<int, int>, 9> directions = {std::make_pair(0, 0), {-1, 0}, {1, 0}, {0,1}, {0, -1}, {-1,-1}, {-1,1}, {1, -1}, {1, 1}};
@@ -1509,7 +1606,7 @@ std::pair<int, int> LifeState::FindSetNeighbour(std::pair<int, int> cell) const
   return std::make_pair(-1, -1);
 }
 
-std::array<std::pair<int, int>, 9> LifeState::NeighbourhoodCells(std::pair<int, int> cell){
+inline std::array<std::pair<int, int>, 9> LifeState::NeighbourhoodCells(std::pair<int, int> cell){
   std::array<std::pair<int, int>, 9> result = {std::make_pair(-1,-1), {-1,0}, {-1,1}, {0,-1}, {0, 0}, {0,1}, {1, -1}, {1, 0}, {1, 1}};
   for (auto &r : result) {
     r.first = (cell.first + r.first + N) % N;
@@ -1518,7 +1615,7 @@ std::array<std::pair<int, int>, 9> LifeState::NeighbourhoodCells(std::pair<int,
   return result;
 }
 
-unsigned LifeState::NeighbourhoodCount(std::pair<int, int> cell) const {
+inline unsigned LifeState::NeighbourhoodCount(std::pair<int, int> cell) const {
   unsigned result = 0;
   const std::array<std::pair<int, int>, 9> neighbours = LifeState::NeighbourhoodCells(cell);
   for (auto n : neighbours) {
@@ -1559,7 +1656,7 @@ inline LifeState LifeState::Match(const LifeTarget &target) const {
   return MatchLiveAndDead(target.wanted, target.unwanted);
 }
 
-std::vector<std::pair<int, int>> LifeState::OnCells() const {
+inline std::vector<std::pair<int, int>> LifeState::OnCells() const {
   LifeState remaining = *this;
   std::vector<std::pair<int, int>> result;
   for(int pop = remaining.GetPop(); pop > 0; pop--) {
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <chrono>
+
 #include "LifeAPI.h"
 #include "Bits.hpp"
+#include "Kernels.hpp"
 
 struct PropagateResult {
   bool consistent;
@@ -40,7 +43,14 @@ public:
   PropagateResult PropagateStable();
 
   std::pair<int, int> UnknownNeighbour(std::pair<int, int> cell) const;
-
+  std::pair<int, int> LeastUnknownNeighbour(std::pair<int, int> cell) const;
+  std::pair<int, int> MostConstrainedNeighbour(std::pair<int, int> cell) const;
+  unsigned UnknownCount(std::pair<int, int> cell) const;
+  unsigned OnCount(std::pair<int, int> cell) const;
+
+  uint64_t PropagateProbesStep(uint64_t probes, bool &changed);
+  uint64_t PropagateProbes(uint64_t probes);
+  PropagateResult TestUnknown(std::pair<int, int> cell);
   PropagateResult TestUnknowns(const LifeState &cells);
   PropagateResult TestUnknownNeighbourhood(std::pair<int, int> cell);
   PropagateResult TestUnknownNeighbourhoods(const LifeState &cells);
@@ -50,7 +60,7 @@ public:
   LifeState Vulnerable() const;
 };
 
-void LifeStableState::SetCell(std::pair<int, int> cell, bool which) {
+inline void LifeStableState::SetCell(std::pair<int, int> cell, bool which) {
   state.SetCellUnsafe(cell, which);
   unknownStable.Erase(cell);
 
@@ -91,7 +101,7 @@ void LifeStableState::SetCell(std::pair<int, int> cell, bool which) {
   }
 }
 
-PropagateResult LifeStableState::PropagateColumnStep(int column) {
+inline PropagateResult LifeStableState::PropagateColumnStep(int column) {
   std::array<uint64_t, 6> nearbyStable;
   std::array<uint64_t, 6> nearbyUnknown;
   std::array<uint64_t, 6> nearbyGlanced;
@@ -199,19 +209,7 @@ PropagateResult LifeStableState::PropagateColumnStep(int column) {
     uint64_t signal_off = 0; // Set an UNKNOWN cell to OFF
     uint64_t signal_on = 0;
 
-// Begin Autogenerated
-set_off |= on2 ;
-set_off |= (~on1) & ((~unk1) | ((~on0) & (~unk0)));
-set_on |= (~on2) & on1 & on0 & (~unk1) ;
-abort |= stateon & on2 & (on1 | on0) ;
-abort |= stateon & (~on1) & on0 & (~unk1) ;
-abort |= on1 & (~unk1) & (~unk0) & (((~stateon) & (~on2) & on0) | (stateon & (~on0))) ;
-signal_off |= (~stateunk) & (~stateon) & (~on2) & on1 & (~on0) & (~unk1) & unk0 ;
-signal_off |= stateon & (~on1) & (((~on0) & unk1) | ((~unk1) & unk0));
-signal_on |= (~stateunk) & (~stateon) & (~on2) & on1 & on0 & (~unk1) ;
-signal_on |= stateon & on1 & (~on0) & (~unk1) ;
-signal_on |= stateon & (~on1) & on0 & (~unk0) ;
-// End Autogenerated
+    StableRuleKernel(stateunk, stateon, on2, on1, on0, unk1, unk0, set_off, set_on, signal_off, signal_on, abort);
 
    // A glanced cell with an ON neighbour
    signal_off |= gl & (~on2) & (~on1) & on0;
@@ -287,7 +285,7 @@ signal_on |= stateon & (~on1) & on0 & (~unk0) ;
   return { true, unknownChanges != 0, edgeChanges != 0 };
 }
 
-void LifeStableState::UpdateZOIColumn(int column) {
+inline void LifeStableState::UpdateZOIColumn(int column) {
   std::array<uint64_t, 4> temp {0};
   for (int i = 0; i < 4; i++) {
     int c = (column + i - 1 + N) % N;
@@ -311,7 +309,7 @@ void LifeStableState::UpdateZOIColumn(int column) {
   }
 }
 
-PropagateResult LifeStableState::PropagateColumn(int column) {
+inline PropagateResult LifeStableState::PropagateColumn(int column) {
   bool done = false;
   bool changed = false;
   bool edgesChanged = false;
@@ -329,7 +327,7 @@ PropagateResult LifeStableState::PropagateColumn(int column) {
   return {true, changed, edgesChanged};
 }
 
-PropagateResult LifeStableState::PropagateStableStep() {
+inline PropagateResult LifeStableState::PropagateStableStep() {
   LifeState startUnknownStable = unknownStable;
 
   LifeState dummy(false);
@@ -369,19 +367,7 @@ PropagateResult LifeStableState::PropagateStableStep() {
     uint64_t signal_on = 0;
     uint64_t abort = 0; // The neighbourhood is inconsistent
 
-// Begin Autogenerated
-set_off |= on2 ;
-set_off |= (~on1) & ((~unk1) | ((~on0) & (~unk0)));
-set_on |= (~on2) & on1 & on0 & (~unk1) ;
-abort |= stateon & on2 & (on1 | on0) ;
-abort |= stateon & (~on1) & on0 & (~unk1) ;
-abort |= on1 & (~unk1) & (~unk0) & (((~stateon) & (~on2) & on0) | (stateon & (~on0))) ;
-signal_off |= (~stateunk) & (~stateon) & (~on2) & on1 & (~on0) & (~unk1) & unk0 ;
-signal_off |= stateon & (~on1) & (((~on0) & unk1) | ((~unk1) & unk0));
-signal_on |= (~stateunk) & (~stateon) & (~on2) & on1 & on0 & (~unk1) ;
-signal_on |= stateon & on1 & (~on0) & (~unk1) ;
-signal_on |= stateon & (~on1) & on0 & (~unk0) ;
-// End Autogenerated
+    StableRuleKernel(stateunk, stateon, on2, on1, on0, unk1, unk0, set_off, set_on, signal_off, signal_on, abort);
 
    // A glanced cell with an ON neighbour
    signal_off |= gl & (~on2) & (~on1) & on0;
@@ -448,7 +434,7 @@ signal_on |= stateon & (~on1) & on0 & (~unk0) ;
   return {has_abort == 0, changes, changes};
 }
 
-PropagateResult LifeStableState::PropagateStable() {
+inline PropagateResult LifeStableState::PropagateStable() {
   bool done = false;
   bool changed = false;
   while (!done) {
@@ -464,53 +450,373 @@ PropagateResult LifeStableState::PropagateStable() {
   return {true, changed, changed};
 }
 
-std::pair<int, int> LifeStableState::UnknownNeighbour(std::pair<int, int> cell) const {
+inline std::pair<int, int> LifeStableState::UnknownNeighbour(std::pair<int, int> cell) const {
   return unknownStable.FindSetNeighbour(cell);
 }
 
-PropagateResult LifeStableState::TestUnknowns(const LifeState &cells) {
-  // Try all the nearby changes to see if any are forced
+// NOTE: these use the neighbour counts, which may lag behind after
+// PropagateColumn
+inline unsigned LifeStableState::UnknownCount(std::pair<int, int> cell) const {
+  return (unknown3.Get(cell) << 3) + (unknown2.Get(cell) << 2) + (unknown1.Get(cell) << 1) + unknown0.Get(cell);
+}
+
+inline unsigned LifeStableState::OnCount(std::pair<int, int> cell) const {
+  return (state2.Get(cell) << 2) + (state1.Get(cell) << 1) + state0.Get(cell);
+}
+
+// The unknown cell near `cell` whose own neighbourhood has the fewest
+// other unknown cells
+inline std::pair<int, int> LifeStableState::LeastUnknownNeighbour(std::pair<int, int> cell) const {
+  std::pair<int, int> best = {-1, -1};
+  unsigned bestCount = std::numeric_limits<unsigned>::max();
+  for (auto n : LifeState::NeighbourhoodCells(cell)) {
+    if (!unknownStable.Get(n))
+      continue;
+    unsigned count = UnknownCount(n);
+    if (count < bestCount) {
+      best = n;
+      bestCount = count;
+    }
+  }
+  return best;
+}
+
+// The unknown cell near `cell` with the most ON cells around it, which
+// is the closest to being forced by propagation
+inline std::pair<int, int> LifeStableState::MostConstrainedNeighbour(std::pair<int, int> cell) const {
+  std::pair<int, int> best = {-1, -1};
+  int bestScore = std::numeric_limits<int>::min();
+  for (auto n : LifeState::NeighbourhoodCells(cell)) {
+    if (!unknownStable.Get(n))
+      continue;
+    int score = 16 * OnCount(n) - UnknownCount(n);
+    if (score > bestScore) {
+      best = n;
+      bestScore = score;
+    }
+  }
+  return best;
+}
+
+// Probes may be placed at most this close together: each one can only
+// change the 6 columns around it, and this leaves enough of a gap that
+// no cell has a neighbourhood touching two of them.
+const unsigned probeSpacing = 8;
+
+// Smaller batches are tested a cell at a time, as a batch costs about as
+// much as testing each of its cells but has more bookkeeping
+const unsigned minProbeBatch = 3;
+
+constexpr uint64_t SmearColumns(uint64_t columns, int below, int above) {
+  uint64_t result = 0;
+  for (int k = -below; k <= above; k++)
+    result |= k < 0 ? RotateRight(columns, -k) : RotateLeft(columns, k);
+  return result;
+}
+
+inline LifeState ColumnMask(uint64_t columns) {
+  LifeState result(false);
+  for (int i = 0; i < N; i++)
+    result[i] = ((columns >> i) & 1) ? ~0ULL : 0;
+  return result;
+}
+
+// PropagateColumnStep for each column of `probes` at once, touching
+// only the columns around them. Reports which columns have a cell whose
+// neighbourhood is inconsistent; the changes are still made there.
+inline uint64_t LifeStableState::PropagateProbesStep(uint64_t probes, bool &changed) {
+  uint64_t windows = SmearColumns(probes, 2, 3);
+  uint64_t centres = SmearColumns(probes, 1, 2);
+
+  std::array<uint64_t, N> oncol0, oncol1, unkcol0, unkcol1;
+  std::array<uint64_t, N> new_off, new_on, signalled_off, signalled_on;
+
+  for (uint64_t remaining = windows; remaining != 0; remaining &= remaining - 1) {
+    int i = __builtin_ctzll(remaining);
+
+    uint64_t a = state[i];
+    uint64_t l = RotateLeft(a);
+    uint64_t r = RotateRight(a);
+    oncol0[i] = l ^ r ^ a;
+    oncol1[i] = ((l ^ r) & a) | (l & r);
+
+    uint64_t u = unknownStable[i];
+    uint64_t ul = RotateLeft(u);
+    uint64_t ur = RotateRight(u);
+    unkcol0[i] = ul ^ ur ^ u;
+    unkcol1[i] = ((ul ^ ur) & u) | (ul & ur);
+
+    new_off[i] = 0;
+    new_on[i] = 0;
+    signalled_off[i] = 0;
+    signalled_on[i] = 0;
+  }
+
+  uint64_t abortColumns = 0;
+
+  for (uint64_t remaining = centres; remaining != 0; remaining &= remaining - 1) {
+    int i = __builtin_ctzll(remaining);
+    int idxU = (i + N - 1) % N;
+    int idxB = (i + 1) % N;
+
+    uint64_t on3, on2, on1, on0;
+    uint64_t unk3, unk2, unk1, unk0;
+
+    {
+      uint64_t uc0, uc1, uc2, uc_carry0;
+      HalfAdd(uc0, uc_carry0, oncol0[idxU], oncol0[i]);
+      FullAdd(uc1, uc2, oncol1[idxU], oncol1[i], uc_carry0);
+
+      uint64_t on_carry1, on_carry0;
+      HalfAdd(on0, on_carry0, uc0, oncol0[idxB]);
+      FullAdd(on1, on_carry1, uc1, oncol1[idxB], on_carry0);
+      HalfAdd(on2, on3, uc2, on_carry1);
+      on2 |= on3;
+      on1 |= on3;
+      on0 |= on3;
+
+      uint64_t ucunk0, ucunk1, ucunk2, ucunk_carry0;
+      HalfAdd(ucunk0, ucunk_carry0, unkcol0[idxU], unkcol0[i]);
+      FullAdd(ucunk1, ucunk2, unkcol1[idxU], unkcol1[i], ucunk_carry0);
+
+      uint64_t unk_carry1, unk_carry0;
+      HalfAdd(unk0, unk_carry0, ucunk0, unkcol0[idxB]);
+      FullAdd(unk1, unk_carry1, ucunk1, unkcol1[idxB], unk_carry0);
+      HalfAdd(unk2, unk3, ucunk2, unk_carry1);
+      unk1 |= unk2 | unk3;
+      unk0 |= unk2 | unk3;
+    }
+
+    uint64_t stateon = state[i];
+    uint64_t stateunk   = unknownStable[i];
+    uint64_t gl        = glanced[i];
+    uint64_t dr        = glancedON[i];
+
+    uint64_t set_off = 0;
+    uint64_t set_on = 0;
+    uint64_t signal_off = 0;
+    uint64_t signal_on = 0;
+    uint64_t abort = 0;
+
+    StableRuleKernel(stateunk, stateon, on2, on1, on0, unk1, unk0, set_off, set_on, signal_off, signal_on, abort);
+
+   // A glanced cell with an ON neighbour
+   signal_off |= gl & (~on2) & (~on1) & on0;
+   // A glanced cell with too many neighbours
+   abort |= gl & (on2 | on1);
+   // A glanced cell that is ON
+   abort |= gl & stateon;
+
+   // A glancedON cell with 2 ON/UNK neighbours
+   signal_on |= dr & (~unk3) & (~unk2) & (~on2) & (~on1) & (((~unk1) & unk0 & on0) | (unk1 & (~unk0) & (~on0)));
+   // A glancedON cell with too few neighbours
+   abort |= dr & (~unk3) & (~unk2) & (~unk1) & (~on2) & (~on1) & (((~unk0) & (~on0)) | (unk0 & (~on0)) | ((~unk0) & on0));
+   // A glancedON cell that is ON
+   abort |= dr & stateon;
+
+   abortColumns |= (uint64_t)(abort != 0) << i;
+
+   new_off[i] = set_off & stateunk;
+   new_on[i]  = set_on  & stateunk;
+
+   signal_off &= unk0 | unk1;
+   signal_on  &= unk0 | unk1;
+
+   uint64_t smear_off = RotateLeft(signal_off) | signal_off | RotateRight(signal_off);
+   signalled_off[idxU] |= smear_off;
+   signalled_off[i]    |= smear_off;
+   signalled_off[idxB] |= smear_off;
+
+   uint64_t smear_on  = RotateLeft(signal_on)  | signal_on  | RotateRight(signal_on);
+   signalled_on[idxU] |= smear_on;
+   signalled_on[i]    |= smear_on;
+   signalled_on[idxB] |= smear_on;
+  }
+
+  changed = false;
+  for (uint64_t remaining = windows; remaining != 0; remaining &= remaining - 1) {
+    int i = __builtin_ctzll(remaining);
+    uint64_t unknown = unknownStable[i];
+
+    abortColumns |= (uint64_t)((unknown & signalled_off[i] & signalled_on[i]) != 0) << i;
+
+    state[i] |= new_on[i] | (signalled_on[i] & unknown);
+    unknownStable[i] = unknown & ~new_on[i] & ~new_off[i] & ~signalled_on[i] & ~signalled_off[i];
+    changed = changed || unknownStable[i] != unknown;
+  }
+
+  return abortColumns;
+}
+
+// Propagates the hypotheses already placed in the columns `probes` all
+// at once, with each probe confined to its own columns. The same as
+// PropagateColumn on each probe separately. Returns the probes that led
+// to a contradiction.
+inline uint64_t LifeStableState::PropagateProbes(uint64_t probes) {
+  uint64_t failed = 0;
+  while (true) {
+    uint64_t live = probes & ~failed;
+    if (live == 0)
+      return failed;
+
+    bool changed;
+    uint64_t abortColumns = PropagateProbesStep(live, changed);
+    // An inconsistent cell is in the window of its probe
+    failed |= live & SmearColumns(abortColumns, 3, 2);
+
+    if (!changed)
+      return failed;
+  }
+}
+
+// Choose one vulnerable cell from each of as many columns as possible,
+// with the columns at least probeSpacing apart
+inline LifeState ProbeBatch(const LifeState &cells) {
+  LifeState result;
+  int first = -1;
+  int last = -1;
+  for (int i = 0; i < N; i++) {
+    if (cells[i] == 0)
+      continue;
+    if (last != -1 && i - last < (int)probeSpacing)
+      continue;
+    if (first != -1 && first + N - i < (int)probeSpacing)
+      break;
+
+    result[i] = cells[i] & -cells[i];
+    if (first == -1)
+      first = i;
+    last = i;
+  }
+  return result;
+}
+
+// Tries both values of one cell, keeping whatever is forced. Only the
+// columns that PropagateColumn can change are saved and restored, rather
+// than copying the whole state for each value.
+inline PropagateResult LifeStableState::TestUnknown(std::pair<int, int> cell) {
+  struct Window {
+    std::array<uint64_t, 6> state;
+    std::array<uint64_t, 6> unknownStable;
+    std::array<uint64_t, 6> stateZOI;
+  };
+  auto save = [&](Window &window) {
+    for (int i = 0; i < 6; i++) {
+      int c = (cell.first + i - 2 + N) % N;
+      window.state[i] = state[c];
+      window.unknownStable[i] = unknownStable[c];
+      window.stateZOI[i] = stateZOI[c];
+    }
+  };
+  auto restore = [&](const Window &window) {
+    for (int i = 0; i < 6; i++) {
+      int c = (cell.first + i - 2 + N) % N;
+      state[c] = window.state[i];
+      unknownStable[c] = window.unknownStable[i];
+      stateZOI[c] = window.stateZOI[i];
+    }
+  };
+
+  Window original, on, off;
+  save(original);
+
+  // Try on
+  state.SetCell(cell, true);
+  unknownStable.Erase(cell);
+  auto onResult = PropagateColumn(cell.first);
+  save(on);
+  restore(original);
+
+  // Try off
+  state.SetCell(cell, false);
+  unknownStable.Erase(cell);
+  auto offResult = PropagateColumn(cell.first);
+  save(off);
+  restore(original);
+
+  if (!onResult.consistent && !offResult.consistent)
+    return {false, false, false};
+
+  if (onResult.consistent && !offResult.consistent) {
+    restore(on);
+    return {true, true, true};
+  }
+
+  if (!onResult.consistent && offResult.consistent) {
+    restore(off);
+    return {true, true, true};
+  }
+
+  bool change = false;
+  if (onResult.changed && offResult.changed) {
+    // Copy over common cells
+    for (int i = 0; i < 6; i++) {
+      int c = (cell.first + i - 2 + N) % N;
+      uint64_t agreement = unknownStable[c] & ~on.unknownStable[i] & ~off.unknownStable[i] & ~(on.state[i] ^ off.state[i]);
+      state[c] |= agreement & on.state[i];
+      unknownStable[c] &= ~agreement;
+      change = change || agreement != 0;
+    }
+  }
+
+  return {true, change, change};
+}
+
+inline PropagateResult LifeStableState::TestUnknowns(const LifeState &cells) {
+  // Try all the nearby changes to see if any are forced. When there are
+  // enough cells far enough apart, the ON and OFF hypotheses for a whole
+  // batch of them are tested at once.
   LifeState remainingCells = cells;
   bool change = false;
   while (!remainingCells.IsEmpty()) {
-    auto cell = remainingCells.FirstOn();
-    remainingCells.Erase(cell);
+    LifeState probes;
+    uint64_t probeColumns = 0;
+    if ((unsigned)__builtin_popcountll(remainingCells.PopulatedColumns()) >= minProbeBatch) {
+      probes = ProbeBatch(remainingCells);
+      probeColumns = probes.PopulatedColumns();
+    }
 
-    // Try on
+    if ((unsigned)__builtin_popcountll(probeColumns) < minProbeBatch) {
+      auto cell = remainingCells.FirstOn();
+      remainingCells.Erase(cell);
 
+      auto result = TestUnknown(cell);
+      if (!result.consistent)
+        return {false, false, false};
+      change = change || result.changed;
+
+      remainingCells &= unknownStable;
+      continue;
+    }
+
+    remainingCells &= ~probes;
+
+    // Try on
     LifeStableState onSearch = *this;
-    onSearch.state.SetCell(cell, true);
-    onSearch.unknownStable.Erase(cell);
-    auto onResult = onSearch.PropagateColumn(cell.first);
+    onSearch.state |= probes;
+    onSearch.unknownStable &= ~probes;
+    uint64_t onFailed = onSearch.PropagateProbes(probeColumns);
 
     // Try off
     LifeStableState offSearch = *this;
-    offSearch.state.SetCell(cell, false);
-    offSearch.unknownStable.Erase(cell);
-    auto offResult = offSearch.PropagateColumn(cell.first);
+    offSearch.unknownStable &= ~probes;
+    uint64_t offFailed = offSearch.PropagateProbes(probeColumns);
 
-    if(!onResult.consistent && !offResult.consistent) {
+    if ((onFailed & offFailed) != 0)
       return {false, false, false};
-    }
 
-    if(onResult.consistent && !offResult.consistent) {
-      *this = onSearch;
-      change = true;
-    }
+    LifeState takeOn = ColumnMask(SmearColumns(offFailed, 2, 3));
+    LifeState takeOff = ColumnMask(SmearColumns(onFailed, 2, 3));
+    LifeState takeBoth = ColumnMask(SmearColumns(probeColumns & ~onFailed & ~offFailed, 2, 3));
 
-    if (!onResult.consistent && offResult.consistent) {
-      *this = offSearch;
-      change = true;
-    }
+    // Copy over common cells
+    LifeState agreement = takeBoth & unknownStable & ~onSearch.unknownStable & ~offSearch.unknownStable & ~(onSearch.state ^ offSearch.state);
 
-    if (onResult.consistent && offResult.consistent && onResult.changed && offResult.changed) {
-      // Copy over common cells
-      LifeState agreement = unknownStable & ~onSearch.unknownStable & ~offSearch.unknownStable & ~(onSearch.state ^ offSearch.state);
-      if (!agreement.IsEmpty()) {
-        state |= agreement & onSearch.state;
-        unknownStable &= ~agreement;
-        change = true;
-      }
+    if (offFailed != 0 || onFailed != 0 || !agreement.IsEmpty()) {
+      LifeState keep = ~takeOn & ~takeOff;
+      state = (state & keep) | (onSearch.state & takeOn) | (offSearch.state & takeOff) | (agreement & onSearch.state);
+      unknownStable = ((unknownStable & keep) | (onSearch.unknownStable & takeOn) | (offSearch.unknownStable & takeOff)) & ~agreement;
+      change = true;
     }
 
     remainingCells &= unknownStable;
@@ -522,7 +828,7 @@ PropagateResult LifeStableState::TestUnknowns(const LifeState &cells) {
     return {true, false, false};
 }
 
-PropagateResult LifeStableState::TestUnknownNeighbourhood(std::pair<int, int> center) {
+inline PropagateResult LifeStableState::TestUnknownNeighbourhood(std::pair<int, int> center) {
   LifeState remainingCells = LifeState::CellZOI(center) & unknownStable;
   bool change = false;
   while (!remainingCells.IsEmpty()) {
@@ -585,7 +891,7 @@ PropagateResult LifeStableState::TestUnknownNeighbourhood(std::pair<int, int> ce
     return {true, false, false};
 }
 
-PropagateResult LifeStableState::TestUnknownNeighbourhoods(const LifeState &cells) {
+inline PropagateResult LifeStableState::TestUnknownNeighbourhoods(const LifeState &cells) {
   LifeState remainingCells = cells;
   bool change = false;
   while (!remainingCells.IsEmpty()) {
@@ -599,7 +905,7 @@ PropagateResult LifeStableState::TestUnknownNeighbourhoods(const LifeState &cell
   return {true, change, change};
 }
 
-bool LifeStableState::CompleteStableStep(std::chrono::system_clock::time_point &timeLimit, bool minimise, unsigned &maxPop, LifeState &best) {
+inline bool LifeStableState::CompleteStableStep(std::chrono::system_clock::time_point &timeLimit, bool minimise, unsigned &maxPop, LifeState &best) {
   auto currentTime = std::chrono::system_clock::now();
   if(currentTime > timeLimit)
     return false;
@@ -683,7 +989,7 @@ bool LifeStableState::CompleteStableStep(std::chrono::system_clock::time_point &
   return offresult || onresult;
 }
 
-LifeState LifeStableState::CompleteStable(unsigned timeout, bool minimise) {
+inline LifeState LifeStableState::CompleteStable(unsigned timeout, bool minimise) {
   LifeState best;
   unsigned maxPop = std::numeric_limits<int>::max();
   LifeState searchArea = state;
@@ -704,7 +1010,7 @@ LifeState LifeStableState::CompleteStable(unsigned timeout, bool minimise) {
   return best;
 }
 
-LifeState LifeStableState::Vulnerable() const {
+inline LifeState LifeStableState::Vulnerable() const {
   return unknownStable
     & (
        (~unknown3 & ~unknown2 & unknown1 & ~unknown0)
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <tuple>
+
 #include "LifeAPI.h"
 #include "Bits.hpp"
+#include "Kernels.hpp"
 #include "LifeStableState.hpp"
 
+struct RecoveryResult {
+  bool recovered;
+  // Unknown stable cells near the reaction that were taken to be OFF
+  LifeState assumedOff;
+};
+
 class LifeUnknownState {
 public:
   LifeState state;
@@ -12,17 +21,21 @@ public:
   LifeState glanceableUnknown;
 
   LifeUnknownState UncertainStepMaintaining(const LifeStableState &stable) const;
+  void UncertainStepMaintainingColumns(const LifeStableState &stable, uint64_t columns, LifeUnknownState &result) const;
   LifeState ActiveComparedTo(const LifeStableState &stable) const;
   bool CompatibleWith(const LifeStableState &stable) const;
+  uint64_t ColumnsUnequalTo(const LifeStableState &stable) const;
 
   std::tuple<uint64_t, uint64_t, uint64_t> UncertainStepColumn(const LifeStableState &stable, int column) const;
   std::tuple<bool, bool, bool> NextForCell(const LifeStableState &stable, std::pair<int, int> cell) const;
   bool KnownNext(const LifeStableState &stable, std::pair<int, int> cell) const;
 
   bool StillGlancingFor(std::pair<int, int> cell, const LifeStableState &stable) const;
+
+  RecoveryResult TestRecovery(const LifeStableState &stable, unsigned gens) const;
 };
 
-LifeUnknownState LifeUnknownState::UncertainStepMaintaining(const LifeStableState &stable) const {
+inline LifeUnknownState LifeUnknownState::UncertainStepMaintaining(const LifeStableState &stable) const {
   LifeUnknownState result;
 
   LifeState state3(false), state2(false), state1(false), state0(false);
@@ -62,14 +75,7 @@ LifeUnknownState LifeUnknownState::UncertainStepMaintaining(const LifeStableStat
     uint64_t next_on = 0;
     uint64_t unknown = 0;
 
-    // ALWAYS CHECK THE PHASE that espresso outputs or you will get confused
-    // Begin Autogenerated
-    unknown |= stateon & (~on1) & (~on0) & (unk1 | unk0);
-    unknown |= (~on2) & unk1 & (on1 | on0 | unk0);
-    unknown |= (~on2) & on1 & unk0 & ~((stateunk | stateon) & on0);
-    next_on |= (stateunk | stateon | ~unk0) & (~on2) & on1 & on0 & (~unk1);
-    next_on |= stateon & (~on1) & (~on0) & (~unk1) & (~unk0);
-    // End Autogenerated
+    UncertainStepKernel(stateunk, stateon, on2, on1, on0, unk1, unk0, next_on, unknown);
 
     result.state[i] = next_on;
     result.unknown[i] = unknown;
@@ -99,7 +105,65 @@ LifeUnknownState LifeUnknownState::UncertainStepMaintaining(const LifeStableStat
   return result;
 }
 
-std::tuple<uint64_t, uint64_t, uint64_t> LifeUnknownState::UncertainStepColumn(const LifeStableState &stable, int column) const {
+// The columns where stepping may give something other than `stable`
+inline uint64_t LifeUnknownState::ColumnsUnequalTo(const LifeStableState &stable) const {
+  return ((state ^ stable.state) | (unknown ^ stable.unknownStable) |
+          (unknownStable ^ stable.unknownStable)).PopulatedColumns();
+}
+
+// UncertainStepMaintaining, but only overwriting the given columns of
+// `result`
+inline void LifeUnknownState::UncertainStepMaintainingColumns(const LifeStableState &stable, uint64_t columns, LifeUnknownState &result) const {
+  while (columns != 0) {
+    int i = __builtin_ctzll(columns);
+    columns &= columns - 1;
+
+    auto [on3, on2, on1, on0] = CountNeighbourhoodColumn(state, i);
+    auto [unk3, unk2, unk1, unk0] = CountNeighbourhoodColumn(unknown, i);
+
+    uint64_t unequal_stable =
+      (state[i] ^ stable.state[i]) | (unknownStable[i] ^ stable.unknownStable[i]) |
+      on3                          | (on2 ^ stable.state2[i]) |
+      (on1 ^ stable.state1[i])     | (on0 ^ stable.state0[i]) |
+      (unk3 ^ stable.unknown3[i])  | (unk2 ^ stable.unknown2[i]) |
+      (unk1 ^ stable.unknown1[i])  | (unk0 ^ stable.unknown0[i]);
+
+    on2 |= on3;
+    on1 |= on3;
+    on0 |= on3;
+
+    unk1 |= unk2 | unk3;
+    unk0 |= unk2 | unk3;
+
+    uint64_t stateon = state[i];
+    uint64_t stateunk = unknown[i];
+
+    uint64_t next_on = 0;
+    uint64_t unknown = 0;
+
+    UncertainStepKernel(stateunk, stateon, on2, on1, on0, unk1, unk0, next_on, unknown);
+
+    uint64_t common_part = unknown &
+      ~(stateon | stateunk | stable.state2[i] | stable.state1[i] | on2);
+
+    result.glanceableUnknown[i] =
+      common_part
+      & (~stable.state0[i])
+      & (~on1) & on0
+      & (unk1 | unk0);
+
+    uint64_t glanceSafe = common_part & ~stable.state0[i] & ~on1;
+    unknown &= ~(glanceSafe & stable.glanced[i]);
+
+    uint64_t toRestore = ~unequal_stable & unknown;
+
+    result.state[i] = (next_on & ~toRestore) | (stable.state[i] & toRestore);
+    result.unknown[i] = (unknown & ~toRestore) | (stable.unknownStable[i] & toRestore);
+    result.unknownStable[i] = stable.unknownStable[i] & toRestore;
+  }
+}
+
+inline std::tuple<uint64_t, uint64_t, uint64_t> LifeUnknownState::UncertainStepColumn(const LifeStableState &stable, int column) const {
   auto [on3, on2, on1, on0] = CountNeighbourhoodColumn(state, column);
   auto [unk3, unk2, unk1, unk0] = CountNeighbourhoodColumn(unknown, column);
 
@@ -123,22 +187,14 @@ std::tuple<uint64_t, uint64_t, uint64_t> LifeUnknownState::UncertainStepColumn(c
   uint64_t next_on = 0;
   uint64_t unknown = 0;
 
-  // ALWAYS CHECK THE PHASE that espresso outputs or you will get confused
-  // Begin Autogenerated
-  unknown |= (~on2) & unk1 & (on1 | on0 | unk0);
-  unknown |= stateon & (~on1) & (~on0) & (unk1 | unk0) ;
-  unknown |= (~stateunk) & (~stateon) & (~on2) & on1 & unk0 ;
-  unknown |= (~on2) & on1 & (~on0) & unk0 ;
-  next_on |= (stateunk | stateon | ~unk0) & (~on2) & on1 & on0 & (~unk1) ;
-  next_on |= stateon & (~on1) & (~on0) & (~unk1) & (~unk0) ;
-  // End Autogenerated
+  UncertainStepKernel(stateunk, stateon, on2, on1, on0, unk1, unk0, next_on, unknown);
 
   uint64_t unknownStable = ~unequal_stable & unknown;
 
   return {next_on, unknown, unknownStable};
 }
 
-std::tuple<bool, bool, bool> LifeUnknownState::NextForCell(const LifeStableState &stable, std::pair<int, int> cell) const {
+inline std::tuple<bool, bool, bool> LifeUnknownState::NextForCell(const LifeStableState &stable, std::pair<int, int> cell) const {
   auto [nextColumn, nextUnknownColumn, nextUnknownStableColumn] = UncertainStepColumn(stable, cell.first);
 
   int y = cell.second;
@@ -148,20 +204,66 @@ std::tuple<bool, bool, bool> LifeUnknownState::NextForCell(const LifeStableState
   return {cellNext, cellUnknown, cellUnknownStable};
 }
 
-bool LifeUnknownState::KnownNext(const LifeStableState &stable, std::pair<int, int> cell) const {
+inline bool LifeUnknownState::KnownNext(const LifeStableState &stable, std::pair<int, int> cell) const {
   auto [cellNext, cellUnknown, cellUnknownStable] = NextForCell(stable, cell);
   return !cellUnknown || cellUnknownStable;
 }
 
-LifeState LifeUnknownState::ActiveComparedTo(const LifeStableState &stable) const {
+inline LifeState LifeUnknownState::ActiveComparedTo(const LifeStableState &stable) const {
   return ~unknown & ~stable.unknownStable & stable.stateZOI & (stable.state ^ state);
 }
 
-bool LifeUnknownState::CompatibleWith(const LifeStableState &stable) const {
+inline bool LifeUnknownState::CompatibleWith(const LifeStableState &stable) const {
   return ActiveComparedTo(stable).IsEmpty();
 }
 
-bool LifeUnknownState::StillGlancingFor(std::pair<int, int> cell, const LifeStableState &stable) const {
+inline bool LifeUnknownState::StillGlancingFor(std::pair<int, int> cell, const LifeStableState &stable) const {
   return !stable.state2.Get(cell) && !stable.state1.Get(cell) &&
     (stable.unknown3.Get(cell) || stable.unknown2.Get(cell) || stable.unknown1.Get(cell) || stable.unknown0.Get(cell));
 }
+
+// Whether a state that looks recovered stays recovered for `gens`
+// generations once the unknown cells around the active ones are taken
+// to be OFF. Everywhere else the state already agrees with `stable`, so
+// only the columns near the active and cleared cells are recounted and
+// stepped.
+inline RecoveryResult LifeUnknownState::TestRecovery(const LifeStableState &stable, unsigned gens) const {
+  LifeStableState assumed = stable;
+  LifeUnknownState current = *this;
+  LifeUnknownState next = *this;
+  LifeState assumedOff;
+  uint64_t stepped = 0;
+
+  for (unsigned i = 1; i < gens; i++) {
+    LifeState active = stable.state ^ current.state;
+    LifeState toClear = active.ZOI().MooreZOI() & assumed.unknownStable;
+
+    current.unknown &= ~toClear;
+    current.unknownStable &= ~toClear;
+    assumed.unknownStable &= ~toClear;
+    assumedOff |= toClear;
+
+    uint64_t recount = SmearColumns(toClear.PopulatedColumns(), 1, 1);
+    while (recount != 0) {
+      int c = __builtin_ctzll(recount);
+      recount &= recount - 1;
+      auto [unknown3, unknown2, unknown1, unknown0] = CountNeighbourhoodColumn(assumed.unknownStable, c);
+      assumed.unknown3[c] = unknown3;
+      assumed.unknown2[c] = unknown2;
+      assumed.unknown1[c] = unknown1;
+      assumed.unknown0[c] = unknown0;
+    }
+
+    // Outside these columns, and those stepped last time, `next`
+    // already matches `current`
+    uint64_t window = SmearColumns((active | assumedOff).PopulatedColumns(), 1, 1);
+    current.UncertainStepMaintainingColumns(assumed, window | stepped, next);
+    std::swap(current, next);
+    stepped = window;
+
+    bool isRecovered = ((stable.state ^ current.state) & stable.stateZOI).IsEmpty();
+    if (!isRecovered)
+      return {false, assumedOff};
+  }
+  return {true, assumedOff};
+}
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <stack>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "LifeAPI.h"
+#include "LifeStableState.hpp"
+#include "LifeUnknownState.hpp"
+
+// A pattern cropped to its bounding box, which must fit in 32x32, so
+// that it can be reoriented without touching the whole grid
+struct CroppedPattern {
+  static const unsigned maxSize = 32;
+
+  unsigned width;
+  unsigned height;
+  std::array<uint32_t, maxSize> columns;
+
+  static bool Crop(const LifeState &state, CroppedPattern &result);
+
+  CroppedPattern FlippedX() const;
+  CroppedPattern FlippedY() const;
+  CroppedPattern Transposed() const;
+
+  CroppedPattern Canonical() const;
+  uint64_t Hash() const;
+
+  auto operator<=>(const CroppedPattern &other) const = default;
+};
+
+inline bool CroppedPattern::Crop(const LifeState &state, CroppedPattern &result) {
+  result.width = 0;
+  result.height = 0;
+  result.columns = {};
+
+  if (state.IsEmpty())
+    return true;
+
+  auto [x1, y1, x2, y2] = state.XYBounds();
+
+  unsigned width = x2 - x1 + 1;
+  unsigned height = y2 - y1 + 1;
+  if (width > maxSize || height > maxSize)
+    return false;
+
+  result.width = width;
+  result.height = height;
+  for (unsigned i = 0; i < width; i++) {
+    uint64_t column = state[(x1 + i + N) % N];
+    result.columns[i] = RotateRight(column, (y1 + N) % N) & ((1ULL << height) - 1);
+  }
+  return true;
+}
+
+inline CroppedPattern CroppedPattern::FlippedX() const {
+  CroppedPattern result = *this;
+  for (unsigned i = 0; i < width; i++)
+    result.columns[i] = columns[width - 1 - i];
+  return result;
+}
+
+inline CroppedPattern CroppedPattern::FlippedY() const {
+  CroppedPattern result = *this;
+  for (unsigned i = 0; i < width; i++) {
+    uint32_t reversed = 0;
+    for (uint32_t column = columns[i]; column != 0; column &= column - 1)
+      reversed |= 1U << (height - 1 - __builtin_ctz(column));
+    result.columns[i] = reversed;
+  }
+  return result;
+}
+
+inline CroppedPattern CroppedPattern::Transposed() const {
+  CroppedPattern result;
+  result.width = height;
+  result.height = width;
+  result.columns = {};
+  for (unsigned i = 0; i < width; i++) {
+    for (uint32_t column = columns[i]; column != 0; column &= column - 1)
+      result.columns[__builtin_ctz(column)] |= 1U << i;
+  }
+  return result;
+}
+
+// The least of the 8 orientations
+inline CroppedPattern CroppedPattern::Canonical() const {
+  CroppedPattern transposed = Transposed();
+  std::array<CroppedPattern, 8> orientations = {
+      *this,      FlippedX(),            FlippedY(),            FlippedX().FlippedY(),
+      transposed, transposed.FlippedX(), transposed.FlippedY(), transposed.FlippedX().FlippedY()};
+  return *std::min_element(orientations.begin(), orientations.end());
+}
+
+inline uint64_t CroppedPattern::Hash() const {
+  uint64_t result = HASH::hash64(width, height);
+  for (unsigned i = 0; i < width; i++)
+    result = HASH::hash64(result, columns[i]);
+  return result;
+}
+
+// Invariant under the 8 orientations, like GetOctoHash, but only
+// transforming the bounding box when that is small
+inline uint64_t RotorHash(const LifeState &state) {
+  CroppedPattern cropped;
+  if (!CroppedPattern::Crop(state, cropped))
+    return state.GetOctoHash();
+  return cropped.Canonical().Hash();
+}
+
+// Steps a state that only differs from `stable` in a few places,
+// skipping the columns where nothing can change
+class LocalStepper {
+public:
+  const LifeStableState &stable;
+  LifeUnknownState current;
+
+  LocalStepper(const LifeStableState &instable, const LifeUnknownState &start)
+      : stable{instable}, current{start}, next{start}, stepped{0} {}
+
+  void Step() {
+    uint64_t window = SmearColumns(current.ColumnsUnequalTo(stable), 1, 1);
+    // Outside these columns, and those stepped last time, `next`
+    // already matches `current`
+    current.UncertainStepMaintainingColumns(stable, window | stepped, next);
+    std::swap(current, next);
+    stepped = window;
+  }
+
+private:
+  LifeUnknownState next;
+  uint64_t stepped;
+};
+
+// The period of the active cells, if they start repeating within
+// `horizon` generations, and 0 otherwise. Leaves `stepper` where the
+// repeat was found.
+inline unsigned OscillationPeriod(LocalStepper &stepper, unsigned horizon) {
+  const LifeStableState &stable = stepper.stable;
+  std::stack<std::pair<uint64_t, int>> minhashes;
+
+  for (unsigned i = 1; i < horizon; i++) {
+    uint64_t newhash = (stable.state ^ stepper.current.state).GetSparseHash();
+
+    while (true) {
+      if (minhashes.empty())
+        break;
+      if (minhashes.top().first < newhash)
+        break;
+
+      if (minhashes.top().first == newhash)
+        return i - minhashes.top().second;
+
+      if (minhashes.top().first > newhash)
+        minhashes.pop();
+    }
+
+    minhashes.push({newhash, i});
+
+    stepper.Step();
+  }
+  return 0;
+}
+
+// A hash of each rotor of an oscillator of the given period
+inline std::vector<uint64_t> RotorHashes(LocalStepper &stepper, unsigned period) {
+  // We shouldn't use the stable state in here, because at this point
+  // we don't care what the original background of the rotor was
+  LifeState startState = stepper.current.state;
+
+  LifeState allRotorCells;
+  for (unsigned i = 0; i < period; i++) {
+    allRotorCells |= startState ^ stepper.current.state;
+    stepper.Step();
+  }
+
+  std::vector<uint64_t> result;
+
+  auto rotorLocations = allRotorCells.Components();
+  for (auto &rotorLocation : rotorLocations) {
+    LifeState rotorZOI = rotorLocation.ZOI();
+    LifeState rotorStart = stepper.current.state & rotorZOI;
+
+    uint64_t rotorHash = 0;
+    for (unsigned i = 0; i < period; i++) {
+      LifeState rotorState = rotorZOI & ~(stepper.current.state & allRotorCells);
+      rotorHash ^= RotorHash(rotorState);
+      stepper.Step();
+      if ((stepper.current.state & rotorZOI) == rotorStart)
+        break;
+    }
+    result.push_back(rotorHash);
+  }
+  return result;
+}
+
+// A hash of the whole cycle of active cells, so an oscillator that has
+// been seen before can be skipped without classifying its rotors. The
+// phase hashes are chained in order, starting from the rotation of the
+// cycle that is smallest, so the result doesn't depend on the starting
+// phase. (XORing them would cancel phases that repeat in another
+// orientation.)
+inline uint64_t OscillatorHash(LocalStepper stepper, unsigned period) {
+  std::vector<uint64_t> phases;
+  for (unsigned i = 0; i < period; i++) {
+    phases.push_back(RotorHash(stepper.stable.state ^ stepper.current.state));
+    stepper.Step();
+  }
+
+  std::vector<uint64_t> canonical = phases;
+  for (unsigned i = 1; i < period; i++) {
+    std::rotate(phases.begin(), phases.begin() + 1, phases.end());
+    canonical = std::min(canonical, phases);
+  }
+
+  uint64_t result = period;
+  for (uint64_t phase : canonical)
+    result = HASH::hash64(result, phase);
+  return result;
+}
+
+// The rotors and oscillators found so far. With a file, those from
+// previous runs are loaded at the start and new ones are appended as
+// they are found. Searches running at once may share a catalogue.
+class RotorCatalogue {
+public:
+  std::unordered_set<uint64_t> rotors;
+  std::unordered_set<uint64_t> oscillators;
+
+  void Open(const std::string &filename);
+
+  bool KnownOscillator(uint64_t hash) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return oscillators.contains(hash);
+  }
+  void AddOscillator(uint64_t hash);
+  bool AddRotor(uint64_t hash);
+
+private:
+  std::ofstream file;
+  mutable std::mutex mutex;
+
+  void Write(const char *kind, uint64_t hash);
+};
+
+// One entry per line, "rotor" or "oscillator" and a hex hash. '#'
+// comments are ignored.
+inline void RotorCatalogue::Open(const std::string &filename) {
+  std::ifstream existing(filename);
+  for (std::string line; std::getline(existing, line);) {
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream fields(line);
+    std::string kind;
+    uint64_t hash;
+    if (!(fields >> kind >> std::hex >> hash)) {
+      throw std::runtime_error("Bad line in rotor catalogue " + filename + ": " + line);
+    }
+    if (kind == "rotor")
+      rotors.insert(hash);
+    else if (kind == "oscillator")
+      oscillators.insert(hash);
+  }
+
+  file.open(filename, std::ios::app);
+  if (!file) {
+    throw std::runtime_error("Could not open rotor catalogue " + filename);
+  }
+}
+
+inline void RotorCatalogue::AddOscillator(uint64_t hash) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (oscillators.insert(hash).second)
+    Write("oscillator", hash);
+}
+
+// Whether the rotor is new
+inline bool RotorCatalogue::AddRotor(uint64_t hash) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!rotors.insert(hash).second)
+    return false;
+  Write("rotor", hash);
+  return true;
+}
+
+inline void RotorCatalogue::Write(const char *kind, uint64_t hash) {
+  if (!file.is_open())
+    return;
+  file << kind << " " << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec << std::endl;
+}
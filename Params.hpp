@@ -1,82 +1,223 @@
 #pragma once
 
+#include <stdexcept>
+
 #include "toml/toml.hpp"
 
 #include "LifeAPI.h"
 #include "LifeHistoryState.hpp"
 #include "Parsing.hpp"
+#include "Forbidden.hpp"
+#include "Blacklist.hpp"
+
+// Which of the candidate focuses found by FindFocuses are preferred
+enum FocusHeuristic {
+  CascadeFocus,  // Near-edge forced-inactive, forced-inactive, near-edge, any
+  PriorityFocus, // Forced-inactive, then any
+  EarliestFocus, // Any, from the earliest generation that has one
+};
+
+// Which unknown cell near the focus is branched on
+enum CellHeuristic {
+  FirstCell,
+  LeastUnknownCell,
+  MostConstrainedCell,
+};
 
-struct Forbidden {
+// A symmetry group, given as a chain of transforms (see JoinWSymChain)
+// applied about a centre. The chain is empty for no symmetry.
+struct Symmetry {
+  std::vector<SymmetryTransform> chain;
+  std::pair<int, int> center;
+
+  LifeState Orbit(const LifeState &state) const {
+    LifeState centered = state;
+    centered.Move(-center.first, -center.second);
+    LifeState result;
+    result.JoinWSymChain(centered, chain);
+    result.Move(center);
+    return result;
+  }
+};
+
+// Names as used by apgsearch and LLS, with the "+" axes vertical then
+// horizontal, and the suffix giving the centre: 1 on a cell, 2 on an
+// edge, 4 on a corner
+inline std::vector<SymmetryTransform> SymmetryChainFor(const std::string &name) {
+  if (name == "C1")    return {};
+  if (name == "C2_1")  return {Rotate180OddBoth};
+  if (name == "C2_2")  return {Rotate180EvenVertical};
+  if (name == "C2_4")  return {Rotate180EvenBoth};
+  if (name == "C4_1")  return {Rotate90, Rotate180OddBoth};
+  if (name == "C4_4")  return {Rotate90Even, Rotate180EvenBoth};
+  if (name == "D2_+1") return {ReflectAcrossY};
+  if (name == "D2_+2") return {ReflectAcrossYEven};
+  if (name == "D2_x")  return {ReflectAcrossYeqX};
+  if (name == "D4_+1") return {ReflectAcrossY, ReflectAcrossX};
+  if (name == "D4_+2") return {ReflectAcrossYEven, ReflectAcrossX};
+  if (name == "D4_+4") return {ReflectAcrossYEven, ReflectAcrossXEven};
+  if (name == "D4_x1") return {ReflectAcrossYeqX, ReflectAcrossYeqNegXP1};
+  if (name == "D4_x4") return {ReflectAcrossYeqX, ReflectAcrossYeqNegX};
+  if (name == "D8_1")  return {Rotate90, Rotate180OddBoth, ReflectAcrossX};
+  if (name == "D8_4")  return {Rotate90Even, Rotate180EvenBoth, ReflectAcrossXEven};
+
+  throw std::runtime_error("Unknown symmetry: " + name);
+}
+
+struct Filter {
+  unsigned gen;
   LifeState mask;
   LifeState state;
 };
 
+// The defaults are those of the TOML keys. When filling these in
+// directly rather than with FromToml, set the pattern with SetPattern
+// and call Prepare before searching.
 struct SearchParams {
 public:
-  unsigned minFirstActiveGen;
-  unsigned maxFirstActiveGen;
-  unsigned minActiveWindowGens;
-  unsigned maxActiveWindowGens;
-  unsigned minStableInterval;
+  unsigned minFirstActiveGen = 0;
+  unsigned maxFirstActiveGen = 100;
+  unsigned minActiveWindowGens = 0;
+  unsigned maxActiveWindowGens = 100;
+  unsigned minStableInterval = 4;
 
   // unsigned maxStablePop;
   // std::pair<unsigned, unsigned> stableBounds;
 
-  int maxActiveCells;
-  std::pair<int, int> activeBounds;
-  int maxComponentActiveCells;
-  std::pair<int, int> componentActiveBounds;
+  int maxActiveCells = -1;
+  std::pair<int, int> activeBounds = {-1, -1};
+  int maxComponentActiveCells = -1;
+  std::pair<int, int> componentActiveBounds = {-1, -1};
+
+  int maxEverActiveCells = -1;
+  std::pair<int, int> everActiveBounds = {-1, -1};
+  int maxComponentEverActiveCells = -1;
+  std::pair<int, int> componentEverActiveBounds = {-1, -1};
+
+  int changesGrace = 0;
+  int maxChanges = -1;
+  std::pair<int, int> changesBounds = {-1, -1};
+  int maxComponentChanges = -1;
+  std::pair<int, int> componentChangesBounds = {-1, -1};
 
-  int maxEverActiveCells;
-  std::pair<int, int> everActiveBounds;
-  int maxComponentEverActiveCells;
-  std::pair<int, int> componentEverActiveBounds;
+  bool usesChanges = false;
 
-  int changesGrace;
-  int maxChanges;
-  std::pair<int, int> changesBounds;
-  int maxComponentChanges;
-  std::pair<int, int> componentChangesBounds;
+  int maxCellActiveWindowGens = -1;
+  int maxCellActiveStreakGens = -1;
 
-  bool usesChanges;
+  int maxCellStationaryDistance = -1;
+  int maxCellStationaryStreakGens = -1;
 
-  int maxCellActiveWindowGens;
-  int maxCellActiveStreakGens;
+  unsigned lookaheadGens = 3;
+  bool adaptiveLookahead = false;
+  std::pair<unsigned, unsigned> lookaheadGensRange = {2, 6};
 
-  int maxCellStationaryDistance;
-  int maxCellStationaryStreakGens;
+  FocusHeuristic focusHeuristic = CascadeFocus;
+  CellHeuristic cellHeuristic = FirstCell;
+  bool branchOnFirst = true;
 
   LifeState startingPattern;
   LifeState activePattern;
+  // Translations of the active pattern that are searched in turn
+  std::vector<std::pair<int, int>> sweepOffsets = {{0, 0}};
+  std::vector<LifeState> sweepPatterns;
   LifeState startingStable;
   LifeState searchArea;
   LifeState stator;
-  bool hasStator;
+  bool hasStator = false;
+
+  // Further reactions that must also succeed with the same stable
+  // state, as active patterns
+  std::vector<LifeState> reactionPatterns;
+
+  bool hasSymmetry = false;
+  Symmetry symmetry = {{}, {0, 0}};
+
+  std::vector<Filter> filters;
+  unsigned maxFilterGen = 0;
+
+  bool hasForbidden = false;
+  ForbiddenMatcher forbidden;
+
+  Blacklist blacklist;
+
+  bool stabiliseResults = true;
+  unsigned stabiliseResultsTimeout = 3;
+  bool minimiseResults = false;
+  bool reportOscillators = false;
+  unsigned oscillatorHorizon = 60;
+  std::string rotorCatalogueFile;
+  bool skipGlancing = true;
+  bool continueAfterSuccess = false;
+  bool printSummary = true;
+  bool pipeResults = false;
+  bool jsonlResults = false;
+  bool dedupeResults = true;
+  std::string resultsIndexFile;
+  bool printStats = false;
+  // Seconds of random probes to estimate the size of the search with
+  unsigned estimateSeconds = 0;
+  bool estimateOnly = false;
+  // Seconds between progress reports, or 0 for none
+  unsigned progressInterval = 0;
+  bool tracePhases = false;
+  // Hardware counters per phase, where perf_event_open is permitted
+  bool traceCounters = false;
+  // A Chrome trace-event file of every phase span
+  std::string traceFile;
+
+  bool debug = false;
 
-  // TODO: of course we might want more than one of these
-  int filterGen;
-  LifeState filterMask;
-  LifeState filterPattern;
+  static SearchParams FromToml(toml::value &toml);
 
-  bool hasForbidden;
-  std::vector<Forbidden> forbiddens;
+  // The LifeHistory layers as in the `pattern` key
+  void SetPattern(const LifeHistoryState &pat);
+  // Fills in the fields derived from the others
+  void Prepare();
+};
 
-  bool stabiliseResults;
-  unsigned stabiliseResultsTimeout;
-  bool minimiseResults;
-  bool reportOscillators;
-  bool skipGlancing;
-  bool continueAfterSuccess;
-  bool forbidEater2;
-  bool printSummary;
-  bool pipeResults;
+inline void SearchParams::SetPattern(const LifeHistoryState &pat) {
+  startingPattern = pat.state;
+  activePattern = pat.state & ~pat.marked;
+  startingStable = pat.marked;
+  searchArea = pat.history;
+  stator = pat.original;
+}
+
+inline void SearchParams::Prepare() {
+  usesChanges = maxChanges != -1 ||
+                changesBounds.first != -1 ||
+                maxComponentChanges != -1 ||
+                componentChangesBounds.first != -1 ||
+                maxCellStationaryDistance != -1 ||
+                maxCellStationaryStreakGens != -1;
+
+  if (pipeResults) {
+    stabiliseResults = true;
+    stabiliseResultsTimeout = 1;
+    minimiseResults = false;
+    printSummary = false;
+  }
+  if (jsonlResults)
+    printSummary = false;
+
+  sweepPatterns.clear();
+  for (auto &offset : sweepOffsets) {
+    LifeState moved = activePattern;
+    moved.Move(offset.first, offset.second);
+    sweepPatterns.push_back(moved);
+  }
 
-  bool debug;
+  hasStator = !stator.IsEmpty();
+  hasSymmetry = !symmetry.chain.empty();
+  hasForbidden = !forbidden.IsEmpty();
 
-  static SearchParams FromToml(toml::value &toml);
-};
+  maxFilterGen = 0;
+  for (auto &filter : filters)
+    maxFilterGen = std::max(maxFilterGen, filter.gen);
+}
 
-SearchParams SearchParams::FromToml(toml::value &toml) {
+inline SearchParams SearchParams::FromToml(toml::value &toml) {
   SearchParams params;
 
   std::vector<int> firstRange = toml::find_or<std::vector<int>>(toml, "first-active-range", {0, 100});
@@ -123,29 +264,63 @@ SearchParams SearchParams::FromToml(toml::value &toml) {
   params.maxCellStationaryDistance = toml::find_or(toml, "max-cell-stationary-distance", -1);
   params.maxCellStationaryStreakGens = toml::find_or(toml, "max-cell-stationary-streak", -1);
 
-  params.usesChanges = params.maxChanges != -1 ||
-                       params.changesBounds.first != -1 ||
-                       params.maxComponentChanges != -1 ||
-                       params.componentChangesBounds.first != -1 ||
-                       params.maxCellStationaryDistance != -1 ||
-                       params.maxCellStationaryStreakGens != -1;
+  params.lookaheadGens = toml::find_or(toml, "lookahead-gens", 3);
+  params.adaptiveLookahead = toml::find_or(toml, "adaptive-lookahead", false);
+  std::vector<int> lookaheadGensRange = toml::find_or<std::vector<int>>(toml, "lookahead-gens-range", {2, 6});
+  params.lookaheadGensRange.first = lookaheadGensRange[0];
+  params.lookaheadGensRange.second = lookaheadGensRange[1];
+
+  std::string focusHeuristic = toml::find_or<std::string>(toml, "focus-heuristic", "cascade");
+  if (focusHeuristic == "cascade")
+    params.focusHeuristic = CascadeFocus;
+  else if (focusHeuristic == "priority")
+    params.focusHeuristic = PriorityFocus;
+  else if (focusHeuristic == "earliest")
+    params.focusHeuristic = EarliestFocus;
+  else {
+    throw std::runtime_error("Unknown focus-heuristic: " + focusHeuristic);
+  }
+
+  std::string cellHeuristic = toml::find_or<std::string>(toml, "cell-heuristic", "first");
+  if (cellHeuristic == "first")
+    params.cellHeuristic = FirstCell;
+  else if (cellHeuristic == "fewest-unknown-neighbours")
+    params.cellHeuristic = LeastUnknownCell;
+  else if (cellHeuristic == "most-constrained")
+    params.cellHeuristic = MostConstrainedCell;
+  else {
+    throw std::runtime_error("Unknown cell-heuristic: " + cellHeuristic);
+  }
+
+  std::string valueOrder = toml::find_or<std::string>(toml, "value-order", "on-first");
+  if (valueOrder == "on-first" || valueOrder == "off-first") {
+    params.branchOnFirst = valueOrder == "on-first";
+  } else {
+    throw std::runtime_error("Unknown value-order: " + valueOrder);
+  }
 
   params.stabiliseResults = toml::find_or(toml, "stabilise-results", true);
   params.stabiliseResultsTimeout = toml::find_or(toml, "stabilise-results-timeout", 3);
   params.minimiseResults = toml::find_or(toml, "minimise-results", false);
   params.reportOscillators = toml::find_or(toml, "report-oscillators", false);
+  params.oscillatorHorizon = toml::find_or(toml, "oscillator-horizon", 60);
+  params.rotorCatalogueFile = toml::find_or<std::string>(toml, "rotor-catalogue", "");
   params.skipGlancing = toml::find_or(toml, "skip-glancing", true);
   params.continueAfterSuccess = toml::find_or(toml, "continue-after-success", false);
-  params.forbidEater2 = toml::find_or(toml, "forbid-eater2", false);
   params.printSummary = toml::find_or(toml, "print-summary", true);
 
+  params.printStats = toml::find_or(toml, "print-stats", false);
+  params.estimateSeconds = toml::find_or(toml, "estimate-seconds", 0);
+  params.estimateOnly = toml::find_or(toml, "estimate-only", false);
+  params.progressInterval = toml::find_or(toml, "progress-interval", 0);
+  params.tracePhases = toml::find_or(toml, "trace-phases", false);
+  params.traceFile = toml::find_or<std::string>(toml, "trace-file", "");
+  params.traceCounters = toml::find_or(toml, "trace-counters", false);
+
   params.pipeResults = toml::find_or(toml, "pipe-results", false);
-  if(params.pipeResults) {
-    params.stabiliseResults = true;
-    params.stabiliseResultsTimeout = 1;
-    params.minimiseResults = false;
-    params.printSummary = false;
-  }
+  params.dedupeResults = toml::find_or(toml, "dedupe-results", true);
+  params.resultsIndexFile = toml::find_or<std::string>(toml, "results-index", "");
+  params.jsonlResults = toml::find_or(toml, "jsonl-results", false);
 
   params.debug = toml::find_or(toml, "debug", false);
 
@@ -157,29 +332,58 @@ SearchParams SearchParams::FromToml(toml::value &toml) {
 
   pat.Move(patternCenter);
 
-  params.startingPattern = pat.state;
-  params.activePattern = pat.state & ~pat.marked;
-  params.startingStable = pat.marked;
-  params.searchArea = pat.history;
-  params.stator = pat.original;
-  params.hasStator = !params.stator.IsEmpty();
+  params.SetPattern(pat);
+
+  std::vector<std::vector<int>> sweepOffsets =
+    toml::find_or<std::vector<std::vector<int>>>(toml, "sweep-offsets", {{0, 0}});
+  params.sweepOffsets.clear();
+  for (auto &offset : sweepOffsets)
+    params.sweepOffsets.push_back({offset[0], offset[1]});
+
+  // Only the active cells of these are used, the stable state and search
+  // area come from the main pattern
+  if (toml.contains("reaction")) {
+    auto reactions = toml::find<std::vector<toml::value>>(toml, "reaction");
+    for (auto &r : reactions) {
+      std::string rle = toml::find<std::string>(r, "pattern");
+      LifeHistoryState pat = ParseLifeHistoryWHeader(rle);
+
+      std::vector<int> centerVec = toml::find_or<std::vector<int>>(r, "pattern-center", {0, 0});
+      pat.Move(-centerVec[0], -centerVec[1]);
 
-  params.filterGen = toml::find_or(toml, "filter-gen", -1);
-  if(params.filterGen != -1) {
-    std::string rle = toml::find_or<std::string>(toml, "filter", "");
+      params.reactionPatterns.push_back(pat.state & ~pat.marked);
+    }
+  }
+
+  std::string symmetry = toml::find_or<std::string>(toml, "symmetry", "C1");
+  params.symmetry.chain = SymmetryChainFor(symmetry);
+  std::vector<int> symmetryCenter = toml::find_or<std::vector<int>>(toml, "symmetry-center", {0, 0});
+  params.symmetry.center = {symmetryCenter[0], symmetryCenter[1]};
+
+  // Either a single filter given by top-level keys, or an array of
+  // [[filter]] tables with the same keys
+  std::vector<toml::value> filterTables;
+  if (toml.contains("filter") && toml.at("filter").is_array())
+    filterTables = toml::find<std::vector<toml::value>>(toml, "filter");
+  else
+    filterTables.push_back(toml);
+
+  for (auto &f : filterTables) {
+    int filterGen = toml::find_or(f, "filter-gen", -1);
+    if (filterGen == -1)
+      continue;
+
+    std::string rle = toml::find_or<std::string>(f, "filter", "");
     LifeHistoryState pat = ParseLifeHistoryWHeader(rle);
 
     std::vector<int> patternCenterVec =
-        toml::find_or<std::vector<int>>(toml, "filter-pos", {0, 0});
+        toml::find_or<std::vector<int>>(f, "filter-pos", {0, 0});
     pat.Move(patternCenterVec[0], patternCenterVec[1]);
 
-    params.filterMask = pat.marked;
-    params.filterPattern = pat.state;
+    params.filters.push_back({(unsigned)filterGen, pat.marked, pat.state});
   }
 
   if(toml.contains("forbidden")) {
-    params.hasForbidden = true;
-
     auto forbiddens = toml::find<std::vector<toml::value>>(toml, "forbidden");
     for(auto &f : forbiddens) {
       std::string rle = toml::find_or<std::string>(f, "forbidden", "");
@@ -189,11 +393,30 @@ SearchParams SearchParams::FromToml(toml::value &toml) {
 
       pat.Move(forbiddenCenterVec[0], forbiddenCenterVec[1]);
 
-      params.forbiddens.push_back({pat.marked, pat.state});
+      // Match in any position and orientation, not just where it was given
+      bool anywhere = toml::find_or(f, "forbidden-anywhere", false);
+      if (anywhere)
+        params.forbidden.AddAnywhere({pat.marked, pat.state});
+      else
+        params.forbidden.AddPositional({pat.marked, pat.state});
     }
-  } else {
-    params.hasForbidden = false;
   }
 
+  if (toml::find_or(toml, "forbid-eater2", false))
+    params.blacklist.AddEater2();
+
+  if (toml.contains("blacklist")) {
+    auto blacklist = toml::find<std::vector<toml::value>>(toml, "blacklist");
+    for (auto &b : blacklist) {
+      std::string rle = toml::find_or<std::string>(b, "blacklist", "");
+      params.blacklist.Add(BlacklistTemplate::Parse(rle));
+    }
+  }
+
+  std::string blacklistFile = toml::find_or<std::string>(toml, "blacklist-file", "");
+  if (!blacklistFile.empty())
+    params.blacklist.AddFile(blacklistFile);
+
+  params.Prepare();
   return params;
 }
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum PerfCounter {
+  PerfCycles,
+  PerfInstructions,
+  PerfL1DMisses,
+  PerfCacheMisses,
+  PerfBranchMisses,
+  PerfCounterCount,
+};
+
+const std::array<const char *, PerfCounterCount> perfCounterNames = {
+    "cycles", "instructions", "L1D-misses", "cache-misses", "branch-misses",
+};
+
+// Hardware counters of the calling thread in user space, opened as one
+// group so they are always read together. Where perf_event_open isn't
+// available or permitted, nothing is opened and Read gives zeros.
+class PerfCounters {
+public:
+  using Values = std::array<uint64_t, PerfCounterCount>;
+
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool Available() const { return fds[0] != -1; }
+  Values Read() const;
+
+private:
+  std::array<int, PerfCounterCount> fds;
+
+  void Close();
+};
+
+#ifdef __linux__
+
+inline PerfCounters::PerfCounters() {
+  fds.fill(-1);
+
+  constexpr uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  const std::array<std::pair<uint32_t, uint64_t>, PerfCounterCount> events = {{
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {PERF_TYPE_HW_CACHE, l1dReadMiss},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  }};
+
+  for (unsigned i = 0; i < PerfCounterCount; i++) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[i].first;
+    attr.config = events[i].second;
+    attr.disabled = i == 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, fds[0], 0);
+    if (fds[i] == -1) {
+      // A partial group would silently mislabel the values
+      Close();
+      return;
+    }
+  }
+
+  ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+inline PerfCounters::~PerfCounters() { Close(); }
+
+inline void PerfCounters::Close() {
+  for (int &fd : fds) {
+    if (fd != -1)
+      close(fd);
+    fd = -1;
+  }
+}
+
+inline PerfCounters::Values PerfCounters::Read() const {
+  struct {
+    uint64_t nr;
+    Values values;
+  } group = {};
+
+  if (Available() && read(fds[0], &group, sizeof(group)) != sizeof(group))
+    group.values = {};
+  return group.values;
+}
+
+#else
+
+inline PerfCounters::PerfCounters() { fds.fill(-1); }
+inline PerfCounters::~PerfCounters() {}
+inline void PerfCounters::Close() {}
+inline PerfCounters::Values PerfCounters::Read() const { return {}; }
+
+#endif
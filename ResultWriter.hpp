@@ -0,0 +1,67 @@
+#pragma once
+
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Writes records to a stream from its own thread, so that a slow
+// consumer never holds up the search. Records are batched and the
+// stream is only flushed once per batch.
+class ResultWriter {
+public:
+  ResultWriter(std::ostream &inout) : out{inout}, done{false}, thread{&ResultWriter::Run, this} {}
+  ~ResultWriter() { Close(); }
+
+  ResultWriter(const ResultWriter &) = delete;
+  ResultWriter &operator=(const ResultWriter &) = delete;
+
+  void Write(const std::string &record);
+  // Wait for everything written so far to reach the stream
+  void Close();
+
+private:
+  std::ostream &out;
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::string pending;
+  bool done;
+  std::thread thread;
+
+  void Run();
+};
+
+inline void ResultWriter::Write(const std::string &record) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending += record;
+  }
+  ready.notify_one();
+}
+
+inline void ResultWriter::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+  }
+  ready.notify_one();
+  if (thread.joinable())
+    thread.join();
+}
+
+inline void ResultWriter::Run() {
+  std::string batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ready.wait(lock, [this] { return done || !pending.empty(); });
+      if (pending.empty() && done)
+        return;
+      batch.swap(pending);
+    }
+    out << batch;
+    out.flush();
+    batch.clear();
+  }
+}
@@ -0,0 +1,1786 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stack>
+
+#include "LifeAPI.h"
+#include "LifeStableState.hpp"
+#include "LifeUnknownState.hpp"
+#include "Oscillator.hpp"
+#include "SolutionIndex.hpp"
+#include "ResultWriter.hpp"
+#include "Params.hpp"
+#include "Trace.hpp"
+
+// The most generations FindFocuses will ever compute in its main
+// lookahead. The number actually used is `lookahead-gens`, or is
+// adjusted during the run by the adaptive lookahead.
+const unsigned maxLookaheadGens = 8;
+const unsigned maxLookaheadKnownPop = 16;
+static_assert(maxLookaheadKnownPop > maxLookaheadGens);
+// Above this many columns a lookahead generation is recomputed whole
+// rather than column by column.
+const unsigned lookaheadPartialColumns = 24;
+
+// How many calls to FindFocuses between adjustments of the adaptive
+// lookahead, and the prune rates that make it widen or narrow.
+const unsigned lookaheadAdaptInterval = 4096;
+const double lookaheadWidenYield = 0.02;
+const double lookaheadNarrowYield = 0.002;
+
+// The countdown widths SearchState can be instantiated with. The
+// smallest one that fits max-cell-active-window and
+// max-cell-active-streak is chosen at startup, and 0 when neither is
+// used so that the timers take no space.
+constexpr std::array<unsigned, 4> cellTimerWidths = {8 - 1, 16 - 1, 32 - 1, 64 - 1};
+
+struct FocusSet {
+  LifeState focuses;
+  LifeState nonGlancingFocuses;
+  LifeState glanceable;
+
+  LifeUnknownState currentState;
+  unsigned currentGen;
+  bool isForcedInactive;
+
+  bool hasNonGlancing;
+
+  FocusSet() = default;
+
+  FocusSet(LifeState &infocuses, LifeState &inglanceable, LifeUnknownState &incurrentState, unsigned incurrentGen, bool inisForcedInactive) {
+    focuses = infocuses;
+    glanceable = inglanceable;
+    currentState = incurrentState;
+    currentGen = incurrentGen;
+    isForcedInactive = inisForcedInactive;
+
+    nonGlancingFocuses = focuses & ~glanceable;
+    hasNonGlancing = !nonGlancingFocuses.IsEmpty();
+  }
+
+  std::pair<int, int> NextFocus()  {
+    std::pair<int, int> focus;
+
+    if(hasNonGlancing) {
+      focus = nonGlancingFocuses.FirstOn();
+      if (focus != std::pair(-1, -1))
+        return focus;
+    }
+    hasNonGlancing = false;
+
+    return focuses.FirstOn();
+  }
+
+  void Erase(std::pair<int, int> cell) {
+    focuses.Erase(cell);
+    nonGlancingFocuses.Erase(cell);
+  }
+};
+
+// Shared by every SearchState in a run. Records, for each lookahead
+// depth, how often FindFocuses reached it and how often the branch was
+// pruned there.
+struct LookaheadStats {
+  unsigned gens;
+  unsigned calls;
+  std::array<uint64_t, maxLookaheadGens + 1> visits;
+  std::array<uint64_t, maxLookaheadGens + 1> prunes;
+
+  LookaheadStats(unsigned ingens) : gens{ingens}, calls{0}, visits{}, prunes{} {}
+
+  void Record(unsigned depth, bool pruned) {
+    if (depth > maxLookaheadGens)
+      return;
+    visits[depth]++;
+    if (pruned)
+      prunes[depth]++;
+  }
+
+  double Yield(unsigned depth) const {
+    if (visits[depth] == 0)
+      return 0;
+    return (double)prunes[depth] / visits[depth];
+  }
+
+  // Widen if the generation just past the lookahead (only seen by the
+  // extended lookahead) is pruning a lot, narrow if the deepest one we
+  // compute is hardly pruning anything.
+  void Adapt(const SearchParams &params) {
+    unsigned deepest = gens - 1;
+
+    if (gens < params.lookaheadGensRange.second && Yield(gens) > lookaheadWidenYield)
+      gens++;
+    else if (gens > params.lookaheadGensRange.first && visits[deepest] > 0 && Yield(deepest) < lookaheadNarrowYield)
+      gens--;
+
+    visits = {};
+    prunes = {};
+  }
+};
+
+// A lookahead computed by FindFocuses, starting at startGen, and the
+// stable cells it was computed from. The next FindFocuses only
+// recomputes the columns in the light cone of what has changed since.
+struct LookaheadCache {
+  std::array<LifeUnknownState, maxLookaheadGens> gens;
+  unsigned size = 0;
+  unsigned startGen = 0;
+  LifeState stableState;
+  LifeState stableUnknown;
+  LifeState stableGlanced;
+};
+
+// Shared by every SearchState in a run. A copied SearchState writes the
+// slot after its parent's, so the parent's lookahead is still there for
+// its other branch to reuse.
+struct LookaheadCaches {
+  std::deque<LookaheadCache> slots;
+
+  LookaheadCache &operator[](unsigned slot) {
+    while (slot >= slots.size())
+      slots.emplace_back();
+    return slots[slot];
+  }
+};
+
+// Shared by every SearchState in a run, for print-stats and the
+// progress reports
+struct SearchStats {
+  uint64_t nodes;
+  std::chrono::steady_clock::time_point startTime;
+  // The fraction of the search tree finished so far
+  double finished;
+  std::chrono::steady_clock::time_point lastProgress;
+  // Only with trace-phases or trace-file
+  Tracer *tracer;
+
+  SearchStats() : nodes{0}, startTime{std::chrono::steady_clock::now()}, finished{0}, lastProgress{startTime}, tracer{nullptr} {}
+
+  void Print(std::ostream &out) const {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    out << "Nodes: " << nodes << std::endl;
+    out << "Time: " << elapsed.count() << std::endl;
+  }
+};
+
+// A random walk down the search tree, following one branch at random
+// wherever the search would follow both. Each node visited stands for
+// 1/share nodes of the whole tree (Knuth's estimator).
+struct Probe {
+  std::mt19937_64 rng;
+  double estimate = 0;
+
+  bool Coin() { return rng() & 1; }
+};
+
+// A solution, as given to SearchControl::onSolution
+struct Solution {
+  // Including the ON cells of the starting stable state
+  LifeState starting;
+  LifeState stable;
+  LifeState unknown;
+  // The whole pattern with the stable state completed, or empty if that
+  // failed or stabilise-results is off
+  LifeState completed;
+  LifeState everActive;
+  unsigned interactionStart;
+  unsigned recoveryGen;
+  // Only for report-oscillators, and 0 otherwise
+  unsigned period;
+  std::pair<int, int> offset;
+};
+
+// For driving a run from other code rather than reading its output
+struct SearchControl {
+  // Called for each solution instead of printing it, on the thread
+  // running the search
+  std::function<void(const Solution &)> onSolution;
+  // May be set from another thread to stop the search early
+  const std::atomic<bool> *cancelled = nullptr;
+};
+
+template <unsigned CountdownMax>
+class SearchState {
+public:
+  using Countdown = LifeCountdown<CountdownMax>;
+
+  LifeStableState stable;
+  LifeUnknownState current;
+
+  LifeState everActive;
+
+  FocusSet pendingFocuses;
+
+  // Monotonically increasing as cells are set, until a step is taken.
+  std::array<uint16_t, maxLookaheadKnownPop> lookaheadKnownPop;
+
+  Countdown activeTimer;
+  Countdown streakTimer;
+
+  std::pair<int, int> focus;
+
+  unsigned currentGen;
+  bool hasInteracted;
+  bool hasReported;
+  unsigned interactionStart;
+  unsigned recoveredTime;
+  // The generation at which the reaction last passed the recovery test
+  unsigned recoveryGen;
+  unsigned sweepIndex;
+
+  // The fraction of the search tree below this state, halved at each
+  // branch
+  double share;
+  // Only set when estimating
+  Probe *probe;
+
+  // The lookahead cache this state writes, and the one its next
+  // FindFocuses starts from
+  unsigned lookaheadSlot;
+  unsigned lookaheadSource;
+
+  // The timeline of a reaction other than the one being searched,
+  // advanced as far as it is known
+  struct PendingReaction {
+    LifeUnknownState current;
+    LifeState everActive;
+    Countdown activeTimer;
+    Countdown streakTimer;
+    unsigned currentGen;
+    bool hasInteracted;
+    unsigned interactionStart;
+    // Stopped at a generation that TryAdvance has to handle
+    bool deferred;
+  };
+  // Reactions that must succeed after this one
+  std::vector<PendingReaction> pendingReactions;
+
+  SearchParams *params;
+  std::vector<LifeState> *allSolutions;
+  RotorCatalogue *rotorCatalogue;
+  SolutionIndex *solutionIndex;
+  LookaheadStats *lookaheadStats;
+  LookaheadCaches *lookaheadCaches;
+  SearchStats *stats;
+  std::ostream *out;
+  // Only used with jsonl-results
+  ResultWriter *resultWriter;
+  const SearchControl *control;
+
+  SearchState(SearchParams &inparams, std::vector<LifeState> &outsolutions, RotorCatalogue &outrotors, SolutionIndex &outindex, LookaheadStats &outlookaheadstats, LookaheadCaches &outlookaheadcaches, SearchStats &outstats, std::ostream &outstream, ResultWriter *outwriter, const SearchControl &incontrol, unsigned insweepIndex = 0);
+  SearchState ( const SearchState & ) = default;
+  SearchState &operator= ( const SearchState & ) = default;
+
+  void TransferStableToCurrent();
+  void TransferStableToCurrentColumn(unsigned column);
+  bool TryAdvance();
+  bool AdvancePendingReaction(PendingReaction &reaction) const;
+  bool AdvancePendingReactions();
+  PendingReaction InitialReaction(const LifeState &pattern) const;
+  void StartReaction(const PendingReaction &reaction);
+  void StartNextReaction();
+  LifeState StartingPattern() const;
+  void AssumeOff(const LifeState &cells);
+
+  std::pair<bool, FocusSet> FindFocuses();
+  std::pair<int, int> ChooseBranchCell(std::pair<int, int> focus) const;
+
+  bool CheckConditionsOn(
+      unsigned gen, bool hasInteracted, unsigned interactionStart,
+      const LifeUnknownState &state, const LifeStableState &stable, const LifeUnknownState &previous, const LifeState &active,
+      const LifeState &everActive,
+      const Countdown &activeTimer, const Countdown &streakTimer) const;
+  LifeState ForcedInactiveCells(
+      unsigned gen, const LifeUnknownState &state,
+      const LifeStableState &stable, const LifeUnknownState &previous,
+      const LifeState &active, const LifeState &everActive,
+      const Countdown &activeTimer, const Countdown &streakTimer) const;
+
+  void Search();
+  void SearchStep();
+  void FinishBranch();
+  void ReportProgress() const;
+
+  bool CheckFiltersOn(unsigned gen, const LifeUnknownState &state) const;
+  bool PassesFilter() const;
+
+  bool SetOrbit(std::pair<int, int> cell, bool which);
+  bool PropagateSymmetry();
+  bool AcceptSolution();
+  Solution CurrentSolution(unsigned period);
+  void ReportSolution(unsigned period = 0);
+  void ReportFullSolution();
+  void ReportPipeSolution();
+  void ReportJsonSolution(unsigned period);
+
+  void SanityCheck();
+};
+
+// std::string SearchState::LifeBellmanRLE() const {
+//   LifeState state = stable | params.activePattern;
+//   LifeState marked =  unknown | stable;
+//   return LifeBellmanRLEFor(state, marked);
+// }
+
+template <unsigned CountdownMax>
+SearchState<CountdownMax>::SearchState(SearchParams &inparams, std::vector<LifeState> &outsolutions, RotorCatalogue &outrotors, SolutionIndex &outindex, LookaheadStats &outlookaheadstats, LookaheadCaches &outlookaheadcaches, SearchStats &outstats, std::ostream &outstream, ResultWriter *outwriter, const SearchControl &incontrol, unsigned insweepIndex)
+  : currentGen{0}, hasInteracted{false}, hasReported{false}, interactionStart{0}, recoveredTime{0}, recoveryGen{0}, sweepIndex{insweepIndex},
+    share{1}, probe{nullptr}, lookaheadSlot{0}, lookaheadSource{0} {
+
+  params = &inparams;
+  allSolutions = &outsolutions;
+  rotorCatalogue = &outrotors;
+  solutionIndex = &outindex;
+  lookaheadStats = &outlookaheadstats;
+  lookaheadCaches = &outlookaheadcaches;
+  stats = &outstats;
+  out = &outstream;
+  resultWriter = outwriter;
+  control = &incontrol;
+
+  stable.state = inparams.startingStable;
+  stable.unknownStable = inparams.searchArea;
+
+  current.state = inparams.sweepPatterns[sweepIndex] | (inparams.startingPattern & inparams.startingStable);
+  current.unknown = stable.unknownStable;
+  current.unknownStable = stable.unknownStable;
+
+  everActive = LifeState();
+  lookaheadKnownPop = {0};
+  focus = {-1, -1};
+  pendingFocuses.focuses = LifeState();
+  activeTimer = Countdown(params->maxCellActiveWindowGens);
+  streakTimer = Countdown(params->maxCellActiveStreakGens);
+
+  for (auto &pattern : params->reactionPatterns)
+    pendingReactions.push_back(InitialReaction(pattern));
+}
+
+template <unsigned CountdownMax>
+typename SearchState<CountdownMax>::PendingReaction
+SearchState<CountdownMax>::InitialReaction(const LifeState &pattern) const {
+  PendingReaction reaction;
+  reaction.current.state = pattern | (params->startingPattern & params->startingStable);
+  reaction.current.unknown = stable.unknownStable;
+  reaction.current.unknownStable = stable.unknownStable;
+  reaction.everActive = LifeState();
+  reaction.activeTimer = activeTimer;
+  reaction.streakTimer = streakTimer;
+  reaction.currentGen = 0;
+  reaction.hasInteracted = false;
+  reaction.interactionStart = 0;
+  reaction.deferred = false;
+  return reaction;
+}
+
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::TransferStableToCurrent() {
+  // Places that in current are unknownStable might be updated now
+  LifeState updated = current.unknownStable & ~stable.unknownStable;
+  current.state |= stable.state & updated;
+  current.unknown &= ~updated;
+  current.unknownStable &= ~updated;
+
+  LifeState focusesUpdated = pendingFocuses.currentState.unknownStable & ~stable.unknownStable;
+  pendingFocuses.currentState.state |= stable.state & focusesUpdated;
+  pendingFocuses.currentState.unknown &= ~focusesUpdated;
+  pendingFocuses.currentState.unknownStable &= ~focusesUpdated;
+}
+
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::TransferStableToCurrentColumn(unsigned column) {
+  for (unsigned i = 0; i < 6; i++) {
+    int c = (column + (int)i - 2 + N) % N;
+    uint64_t updated = current.unknownStable[c] & ~stable.unknownStable[c];
+    current.state[c] |= stable.state[c] & updated;
+    current.unknown[c] &= ~updated;
+    current.unknownStable[c] &= ~updated;
+
+    uint64_t focusesUpdated = pendingFocuses.currentState.unknownStable[c] & ~stable.unknownStable[c];
+    pendingFocuses.currentState.state[c] |= stable.state[c] & focusesUpdated;
+    pendingFocuses.currentState.unknown[c] &= ~focusesUpdated;
+    pendingFocuses.currentState.unknownStable[c] &= ~focusesUpdated;
+  }
+}
+
+template <unsigned CountdownMax>
+bool SearchState<CountdownMax>::CheckConditionsOn(
+    unsigned gen, bool hasInteracted, unsigned interactionStart,
+    const LifeUnknownState &state, const LifeStableState &stable,
+    const LifeUnknownState &previous, const LifeState &active,
+    const LifeState &everActive,
+    const Countdown &activeTimer, const Countdown &streakTimer) const {
+  auto activePop = active.GetPop();
+
+  if (gen < params->minFirstActiveGen && activePop > 0)
+    return false;
+
+  if (params->maxActiveCells != -1 && activePop > (unsigned)params->maxActiveCells)
+    return false;
+
+  if (params->maxComponentActiveCells != -1 && activePop > (unsigned)params->maxComponentActiveCells)
+    for (auto &c : active.Components())
+      if(c.GetPop() > (unsigned)params->maxComponentActiveCells)
+        return false;
+
+  if (gen > interactionStart + params->changesGrace && params->usesChanges) {
+    LifeState changes = (state.state ^ previous.state) & ~state.unknown & ~previous.unknown & stable.stateZOI;
+    if (params->maxChanges != -1) {
+      if (changes.GetPop() > (unsigned)params->maxChanges)
+        return false;
+    }
+
+    if (params->maxComponentChanges != -1) {
+      for (auto &c : changes.Components())
+        if (c.GetPop() > (unsigned)params->maxComponentChanges)
+          return false;
+    }
+
+    if (params->changesBounds.first != -1) {
+      auto wh = changes.WidthHeight();
+      if (wh.first > params->changesBounds.first || wh.second > params->changesBounds.second)
+        return false;
+    }
+
+    if (params->componentChangesBounds.first != -1) {
+      auto wh = changes.WidthHeight();
+      if (wh.first > params->componentChangesBounds.first || wh.second > params->componentChangesBounds.second) {
+        for (auto &c : changes.Components()) {
+          auto wh = c.WidthHeight();
+          if (wh.first > params->componentChangesBounds.first || wh.second > params->componentChangesBounds.second)
+            return false;
+        }
+      }
+    }
+
+    if (params->maxCellStationaryDistance != -1) {
+      LifeState stationary = active & ~changes;
+      LifeState unknownActive = state.unknown & ~state.unknownStable;
+      if (!stationary.IsEmpty() && (stationary.NZOI(params->maxCellStationaryDistance) & (changes | unknownActive)).IsEmpty()) {
+        return false;
+      }
+    }
+  }
+
+  if(hasInteracted && !params->reportOscillators && gen > interactionStart + params->maxActiveWindowGens && activePop > 0)
+    return false;
+
+  if (params->maxCellActiveWindowGens != -1 && gen > (unsigned)params->maxCellActiveWindowGens && !(active & activeTimer.finished).IsEmpty())
+    return false;
+
+  if (params->maxCellActiveStreakGens != -1 && gen > (unsigned)params->maxCellActiveStreakGens && !(active & streakTimer.finished).IsEmpty())
+    return false;
+
+  if(params->activeBounds.first != -1) {
+    auto wh = active.WidthHeight();
+    if (wh.first > params->activeBounds.first || wh.second > params->activeBounds.second)
+      return false;
+  }
+
+  if (params->componentActiveBounds.first != -1) {
+    auto wh = active.WidthHeight();
+    if (wh.first > params->componentActiveBounds.first || wh.second > params->componentActiveBounds.second) {
+      for (auto &c : active.Components()) {
+        auto wh = c.WidthHeight();
+        if (wh.first > params->componentActiveBounds.first || wh.second > params->componentActiveBounds.second)
+          return false;
+      }
+    }
+  }
+
+  if (params->maxEverActiveCells != -1 && everActive.GetPop() > (unsigned)params->maxEverActiveCells)
+    return false;
+
+  if (params->maxComponentEverActiveCells != -1 && everActive.GetPop() > (unsigned)params->maxComponentEverActiveCells)
+    for (auto &c : everActive.Components())
+      if(c.GetPop() > (unsigned)params->maxComponentEverActiveCells)
+        return false;
+
+  if(params->everActiveBounds.first != -1) {
+    auto wh = everActive.WidthHeight();
+    if (wh.first > params->everActiveBounds.first || wh.second > params->everActiveBounds.second)
+      return false;
+  }
+
+  if (params->componentEverActiveBounds.first != -1) {
+    auto wh = everActive.WidthHeight();
+    if (wh.first > params->componentEverActiveBounds.first || wh.second > params->componentEverActiveBounds.second) {
+      for (auto &c : everActive.Components()) {
+        auto wh = c.WidthHeight();
+        if (wh.first > params->componentEverActiveBounds.first || wh.second > params->componentEverActiveBounds.second)
+          return false;
+      }
+    }
+  }
+
+  if (params->hasStator && !(~state.state & params->stator & ~state.unknown).IsEmpty())
+      return false;
+
+  if (!CheckFiltersOn(gen, state))
+    return false;
+
+  return true;
+}
+
+// Whether the known cells of `state` agree with every filter for `gen`
+template <unsigned CountdownMax>
+bool SearchState<CountdownMax>::CheckFiltersOn(unsigned gen, const LifeUnknownState &state) const {
+  for (auto &f : params->filters) {
+    if (f.gen == gen &&
+        !((state.state ^ f.state) & f.mask & ~state.unknown).IsEmpty())
+      return false;
+  }
+  return true;
+}
+
+// Cells that must be inactive or CheckConditions will fail
+// So, it should be that CheckConditionsOn == !(ForcedInactiveCells &
+// active).IsEmpty()
+template <unsigned CountdownMax>
+LifeState SearchState<CountdownMax>::ForcedInactiveCells(
+    unsigned gen, const LifeUnknownState &state, const LifeStableState &stable,
+    const LifeUnknownState &previous, const LifeState &active,
+    const LifeState &everActive,
+    const Countdown &activeTimer, const Countdown &streakTimer) const {
+  if (gen < params->minFirstActiveGen) {
+    return ~LifeState();
+  }
+
+  auto activePop = active.GetPop();
+
+  if (hasInteracted && !params->reportOscillators && gen > interactionStart + params->maxActiveWindowGens && activePop > 0) {
+    return ~LifeState();
+  }
+
+  if (params->maxActiveCells != -1 &&
+      activePop > (unsigned)params->maxActiveCells)
+    return ~LifeState();
+
+  LifeState result;
+
+  if (params->maxActiveCells != -1 &&
+      activePop == (unsigned)params->maxActiveCells)
+    result |= ~active; // Or maybe just return
+
+  if (params->maxComponentActiveCells != -1 && activePop >= (unsigned)params->maxComponentActiveCells) {
+    for (auto &c : active.Components()) {
+      auto componentPop = c.GetPop();
+      if(componentPop > (unsigned)params->maxComponentActiveCells)
+        return ~LifeState();
+      if(componentPop == (unsigned)params->maxComponentActiveCells)
+        result |= ~active & c.BigZOI();
+    }
+  }
+
+  if (gen > interactionStart + params->changesGrace && params->usesChanges) {
+    LifeState changesForbidden;
+
+    LifeState changes = (state.state ^ previous.state) & ~state.unknown & ~previous.unknown & stable.stateZOI;
+
+    if (params->maxChanges != -1) {
+      unsigned changesPop = changes.GetPop();
+      if (changesPop > (unsigned)params->maxChanges)
+        return ~LifeState();
+      if (changesPop == (unsigned)params->maxChanges) {
+        changesForbidden |= ~changes;
+      }
+    }
+
+    if (params->maxComponentChanges != -1) {
+      for (auto &c : changes.Components()) {
+        unsigned changesPop = c.GetPop();
+        if (changesPop > (unsigned)params->maxComponentChanges)
+          return ~LifeState();
+        if (changesPop == (unsigned)params->maxComponentChanges) {
+          changesForbidden |= ~changes & c.BigZOI();
+        }
+      }
+    }
+
+    if (params->changesBounds.first != -1) {
+      changesForbidden |= ~changes.BufferAround(params->changesBounds);
+    }
+
+    if (params->componentChangesBounds.first != -1) {
+      for (auto &c : changes.Components()) {
+        auto wh = c.WidthHeight();
+        if (wh.first > params->componentChangesBounds.first || wh.second > params->componentChangesBounds.second)
+          return ~LifeState();
+
+        changesForbidden |= ~c.BufferAround(params->componentChangesBounds) & c.BigZOI();
+      }
+    }
+
+    LifeState prevactive = previous.ActiveComparedTo(stable);
+
+    result |= changesForbidden & ~previous.unknown & ~prevactive;
+
+    if (params->maxCellStationaryDistance != -1) {
+      LifeState unchanging = ~(changes | (state.unknown & ~state.unknownStable));
+      result |= prevactive & unchanging.MatchLive(LifeState::NZOIAround({0, 0}, params->maxCellStationaryDistance));
+    }
+  }
+
+  if (params->maxCellActiveWindowGens != -1 &&
+      currentGen > (unsigned)params->maxCellActiveWindowGens)
+    result |= activeTimer.finished;
+
+  if (params->maxCellActiveStreakGens != -1 &&
+      currentGen > (unsigned)params->maxCellActiveStreakGens)
+    result |= streakTimer.finished;
+
+  if (params->activeBounds.first != -1 && activePop > 0) {
+    result |= ~active.BufferAround(params->activeBounds);
+  }
+
+  if (params->componentActiveBounds.first != -1) {
+    for (auto &c : active.Components()) {
+      auto wh = c.WidthHeight();
+
+      if (wh.first > params->componentActiveBounds.first || wh.second > params->componentActiveBounds.second)
+        return ~LifeState();
+
+      result |= ~c.BufferAround(params->componentActiveBounds) & c.BigZOI();
+    }
+  }
+
+  if (params->maxEverActiveCells != -1 &&
+      everActive.GetPop() == (unsigned)params->maxEverActiveCells) {
+    result |= ~everActive; // Or maybe just return
+  }
+
+  if (params->maxComponentEverActiveCells != -1 && everActive.GetPop() >= (unsigned)params->maxComponentEverActiveCells) {
+    for (auto &c : everActive.Components()) {
+      auto componentPop = c.GetPop();
+      if(componentPop > (unsigned)params->maxComponentEverActiveCells)
+        return ~LifeState();
+      if(componentPop == (unsigned)params->maxComponentEverActiveCells)
+        result |= ~everActive & c.BigZOI();
+    }
+  }
+
+  if (params->everActiveBounds.first != -1 && activePop > 0) {
+    result |= ~everActive.BufferAround(params->everActiveBounds);
+  }
+
+  if (params->componentEverActiveBounds.first != -1) {
+    for (auto &c : everActive.Components()) {
+      auto wh = c.WidthHeight();
+
+      if (wh.first > params->componentEverActiveBounds.first || wh.second > params->componentEverActiveBounds.second)
+        return ~LifeState();
+
+      result |= ~c.BufferAround(params->componentEverActiveBounds) & c.BigZOI();
+    }
+  }
+
+  if (params->hasStator)
+    result |= params->stator;
+
+  return result;
+}
+
+template <unsigned CountdownMax>
+bool SearchState<CountdownMax>::TryAdvance() {
+  while (true) {
+    LifeUnknownState next = Traced(stats->tracer, TraceUncertainStep, [&] { return current.UncertainStepMaintaining(stable); });
+    bool fullyKnown = (next.unknown ^ next.unknownStable).IsEmpty();
+
+    if (!fullyKnown)
+      break;
+
+    // Test whether we interact now
+    if(!hasInteracted) {
+      LifeState steppedWithoutStable = (current.state & ~stable.state);
+      steppedWithoutStable.Step();
+
+      bool isDifferent = !(next.state ^ (steppedWithoutStable | stable.state)).IsEmpty();
+
+      if (isDifferent) {
+        // Too early:
+        if (currentGen < params->minFirstActiveGen)
+          return false;
+
+        hasInteracted = true;
+        interactionStart = currentGen;
+      } else {
+        // Too late:
+        if(currentGen > params->maxFirstActiveGen)
+          return false;
+      }
+    }
+
+    LifeUnknownState previous = current;
+    current = next;
+    currentGen++;
+    lookaheadKnownPop = {0};
+
+    // Test recovery
+    if (hasInteracted) {
+      bool isRecovered = ((stable.state ^ current.state) & stable.stateZOI).IsEmpty();
+
+      if (!hasReported && isRecovered && recoveredTime == 0) {
+        // See whether this is already a solution with no additional ON cells
+        RecoveryResult recovery = Traced(stats->tracer, TraceRecovery, [&] {
+          return current.TestRecovery(stable, params->minStableInterval);
+        });
+        if (recovery.recovered) {
+          recoveryGen = currentGen;
+          if(currentGen >= interactionStart + params->minActiveWindowGens && !params->reportOscillators) {
+            SearchState testState = *this;
+            testState.lookaheadSlot++;
+            // Not a branch of the search tree, so not part of the progress
+            if (!probe)
+              testState.share = 0;
+            testState.AssumeOff(recovery.assumedOff);
+
+            if (pendingReactions.empty()) {
+              testState.ReportSolution();
+            } else {
+              testState.StartNextReaction();
+              testState.SearchStep();
+            }
+          }
+          hasReported = true;
+          if(!params->continueAfterSuccess)
+            return false;
+        }
+      }
+
+      if (isRecovered)
+        recoveredTime++;
+      else
+        recoveredTime = 0;
+
+      if (currentGen > interactionStart + params->maxActiveWindowGens) {
+        if(params->reportOscillators && !probe) {
+          LocalStepper stepper(stable, current);
+          auto [period, oscillator] = Traced(stats->tracer, TraceOscillation, [&] {
+            unsigned period = OscillationPeriod(stepper, params->oscillatorHorizon);
+            uint64_t oscillator = period > 3 ? OscillatorHash(stepper, period) : 0;
+            return std::make_pair(period, oscillator);
+          });
+          if (period > 3 && !rotorCatalogue->KnownOscillator(oscillator)) {
+            auto rotors = Traced(stats->tracer, TraceOscillation, [&] { return RotorHashes(stepper, period); });
+            bool anyNew = false;
+            for(uint64_t r : rotors) {
+              if(rotorCatalogue->AddRotor(r))
+                anyNew = true;
+            }
+            rotorCatalogue->AddOscillator(oscillator);
+            if(anyNew) {
+              if (!params->jsonlResults && !control->onSolution)
+                *out << "Oscillating! Period: " << period << std::endl;
+              ReportSolution(period);
+            }
+          }
+        }
+
+        return false;
+      }
+    }
+
+    LifeState active = current.ActiveComparedTo(stable);
+    everActive |= active;
+
+    if (params->maxCellActiveWindowGens != -1) {
+      activeTimer.Start(active);
+      activeTimer.Tick();
+    }
+
+    if (params->maxCellActiveStreakGens != -1) {
+      streakTimer.Reset(~active);
+      streakTimer.Start(active);
+      streakTimer.Tick();
+    }
+
+    if (!CheckConditionsOn(currentGen, hasInteracted, interactionStart, current, stable, previous, active, everActive, activeTimer, streakTimer))
+      return false;
+  }
+
+  return true;
+}
+
+// As TryAdvance, for a reaction that is not being searched yet. It
+// stops short of the generation where the reaction recovers, and the
+// rest happens in TryAdvance when it becomes the current reaction.
+template <unsigned CountdownMax>
+bool SearchState<CountdownMax>::AdvancePendingReaction(PendingReaction &reaction) const {
+  LifeState updated = reaction.current.unknownStable & ~stable.unknownStable;
+  reaction.current.state |= stable.state & updated;
+  reaction.current.unknown &= ~updated;
+  reaction.current.unknownStable &= ~updated;
+
+  while (!reaction.deferred) {
+    LifeUnknownState next = reaction.current.UncertainStepMaintaining(stable);
+    bool fullyKnown = (next.unknown ^ next.unknownStable).IsEmpty();
+
+    if (!fullyKnown)
+      break;
+
+    if (!reaction.hasInteracted) {
+      LifeState steppedWithoutStable = (reaction.current.state & ~stable.state);
+      steppedWithoutStable.Step();
+
+      bool isDifferent = !(next.state ^ (steppedWithoutStable | stable.state)).IsEmpty();
+
+      if (isDifferent) {
+        if (reaction.currentGen < params->minFirstActiveGen)
+          return false;
+
+        reaction.hasInteracted = true;
+        reaction.interactionStart = reaction.currentGen;
+      } else {
+        if (reaction.currentGen > params->maxFirstActiveGen)
+          return false;
+      }
+    }
+
+    if (reaction.hasInteracted) {
+      // TryAdvance tests recovery, and reports oscillators at the end of
+      // the window, so leave those generations to it
+      bool isRecovered = ((stable.state ^ next.state) & stable.stateZOI).IsEmpty();
+      bool windowOver = reaction.currentGen + 1 > reaction.interactionStart + params->maxActiveWindowGens;
+      if (isRecovered || (windowOver && params->reportOscillators)) {
+        reaction.deferred = true;
+        break;
+      }
+      if (windowOver)
+        return false;
+    }
+
+    LifeUnknownState previous = reaction.current;
+    reaction.current = next;
+    reaction.currentGen++;
+
+    LifeState active = reaction.current.ActiveComparedTo(stable);
+    reaction.everActive |= active;
+
+    if (params->maxCellActiveWindowGens != -1) {
+      reaction.activeTimer.Start(active);
+      reaction.activeTimer.Tick();
+    }
+
+    if (params->maxCellActiveStreakGens != -1) {
+      reaction.streakTimer.Reset(~active);
+      reaction.streakTimer.Start(active);
+      reaction.streakTimer.Tick();
+    }
+
+    if (!CheckConditionsOn(reaction.currentGen, reaction.hasInteracted, reaction.interactionStart,
+                           reaction.current, stable, previous, active,
+                           reaction.everActive, reaction.activeTimer, reaction.streakTimer))
+      return false;
+  }
+
+  return true;
+}
+
+template <unsigned CountdownMax>
+bool SearchState<CountdownMax>::AdvancePendingReactions() {
+  for (auto &reaction : pendingReactions) {
+    if (!AdvancePendingReaction(reaction))
+      return false;
+  }
+  return true;
+}
+
+// Make `reaction` the one being searched
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::StartReaction(const PendingReaction &reaction) {
+  current = reaction.current;
+  everActive = reaction.everActive;
+  activeTimer = reaction.activeTimer;
+  streakTimer = reaction.streakTimer;
+  currentGen = reaction.currentGen;
+  hasInteracted = reaction.hasInteracted;
+  interactionStart = reaction.interactionStart;
+  recoveredTime = 0;
+  recoveryGen = 0;
+  hasReported = false;
+
+  lookaheadKnownPop = {0};
+  focus = {-1, -1};
+  pendingFocuses = FocusSet();
+  pendingFocuses.focuses = LifeState();
+}
+
+// The current reaction has succeeded, so search the next one on the
+// same stable state
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::StartNextReaction() {
+  StartReaction(pendingReactions.front());
+  pendingReactions.erase(pendingReactions.begin());
+}
+
+template <unsigned CountdownMax>
+LifeState SearchState<CountdownMax>::StartingPattern() const {
+  return params->sweepPatterns[sweepIndex] | (params->startingPattern & params->startingStable);
+}
+
+// Take unknown stable cells to be OFF, as a successful recovery test
+// did
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::AssumeOff(const LifeState &cells) {
+  current.unknown &= ~cells;
+  current.unknownStable &= ~cells;
+  stable.unknownStable &= ~cells;
+  CountNeighbourhood(stable.unknownStable, stable.unknown3, stable.unknown2, stable.unknown1, stable.unknown0);
+}
+
+template <unsigned CountdownMax>
+std::pair<bool, FocusSet> SearchState<CountdownMax>::FindFocuses() {
+  if (params->adaptiveLookahead && ++lookaheadStats->calls % lookaheadAdaptInterval == 0)
+    lookaheadStats->Adapt(*params);
+
+  const unsigned lookaheadGens = lookaheadStats->gens;
+
+  LookaheadCache &cache = (*lookaheadCaches)[lookaheadSlot];
+  auto &lookahead = cache.gens;
+
+  // Columns where the generation may differ from the cached one
+  uint64_t dirty = ~0ULL;
+  unsigned cached = 0;
+  {
+    LookaheadCache &source = (*lookaheadCaches)[lookaheadSource];
+    if (currentGen >= source.startGen && currentGen - source.startGen < source.size) {
+      unsigned offset = currentGen - source.startGen;
+      cached = source.size - offset;
+      if (&source != &cache || offset > 0)
+        std::copy(source.gens.begin() + offset, source.gens.begin() + source.size, lookahead.begin());
+
+      LifeState changedStable = (stable.state ^ source.stableState) |
+                                (stable.unknownStable ^ source.stableUnknown) |
+                                (stable.glanced ^ source.stableGlanced);
+      LifeState changedCurrent = (current.state ^ lookahead[0].state) |
+                                 (current.unknown ^ lookahead[0].unknown) |
+                                 (current.unknownStable ^ lookahead[0].unknownStable);
+      dirty = (changedStable | changedCurrent).PopulatedColumns();
+    }
+  }
+
+  lookaheadSource = lookaheadSlot;
+  cache.startGen = currentGen;
+  cache.size = 1;
+  cache.stableState = stable.state;
+  cache.stableUnknown = stable.unknownStable;
+  cache.stableGlanced = stable.glanced;
+
+  unsigned lookaheadSize = 1;
+
+  std::array<LifeState, maxLookaheadGens> allFocusable;
+  std::array<bool, maxLookaheadGens> genHasFocusable;
+  std::array<LifeState, maxLookaheadGens> allForcedInactive;
+  auto lookaheadTimer = activeTimer;
+  auto lookaheadStreakTimer = streakTimer;
+
+  lookahead[0] = current;
+  unsigned i;
+  for (i = 1; i < lookaheadGens; i++) {
+    dirty = SmearColumns(dirty, 1, 1);
+    if (i < cached && (unsigned)__builtin_popcountll(dirty) <= lookaheadPartialColumns)
+      lookahead[i - 1].UncertainStepMaintainingColumns(stable, dirty, lookahead[i]);
+    else
+      lookahead[i] = Traced(stats->tracer, TraceUncertainStep, [&] { return lookahead[i - 1].UncertainStepMaintaining(stable); });
+    lookaheadSize = i + 1;
+    cache.size = lookaheadSize;
+    LifeUnknownState &gen = lookahead[i];
+    LifeUnknownState &prev = lookahead[i-1];
+
+    LifeState active = gen.ActiveComparedTo(stable);
+
+    everActive |= active;
+    if (params->maxCellActiveWindowGens != -1) {
+      lookaheadTimer.Start(active);
+      lookaheadTimer.Tick();
+    }
+    if (params->maxCellActiveStreakGens != -1) {
+      lookaheadStreakTimer.Reset(~active);
+      lookaheadStreakTimer.Start(active);
+      lookaheadStreakTimer.Tick();
+    }
+
+    allForcedInactive[i] = ForcedInactiveCells(currentGen + i, gen, stable, prev, active, everActive, lookaheadTimer, lookaheadStreakTimer);
+
+    bool pruned = !(allForcedInactive[i] & active).IsEmpty() ||
+                  !CheckFiltersOn(currentGen + i, gen);
+    lookaheadStats->Record(i, pruned);
+    if (pruned)
+      return {false, FocusSet()};
+
+    LifeState becomeUnknown = (gen.unknown & ~gen.unknownStable) & ~(prev.unknown & ~prev.unknownStable);
+    LifeState nearActiveUnknown = (prev.unknown & ~prev.unknownStable).ZOI();
+
+    allFocusable[i] = becomeUnknown & ~nearActiveUnknown;
+    genHasFocusable[i] = !allFocusable[i].IsEmpty();
+
+    unsigned knownPop = (~gen.unknown & ~stable.unknownStable & stable.stateZOI).GetPop();
+    if (currentGen + i > pendingFocuses.currentGen && knownPop == lookaheadKnownPop[i])
+      break;
+    lookaheadKnownPop[i] = knownPop;
+  }
+
+  // Continue the lookahead until we run out of active cells
+  if (hasInteracted && lookaheadSize == lookaheadGens) {
+    LifeUnknownState gen = lookahead[lookaheadGens - 1];
+    for(unsigned i = lookaheadGens; currentGen + i <= interactionStart + params->maxActiveWindowGens + 1; i++) {
+      LifeUnknownState prev = gen;
+      gen = gen.UncertainStepMaintaining(stable);
+      LifeState active = gen.ActiveComparedTo(stable);
+
+      if (i < maxLookaheadKnownPop) {
+        unsigned knownPop = (~gen.unknown & ~stable.unknownStable & stable.stateZOI).GetPop();
+        if (knownPop == lookaheadKnownPop[i])
+          break;
+        lookaheadKnownPop[i] = knownPop;
+      } else {
+        if(active.IsEmpty())
+          break;
+      }
+
+      everActive |= active;
+
+      if (params->maxCellActiveWindowGens != -1) {
+        lookaheadTimer.Start(active);
+        lookaheadTimer.Tick();
+      }
+      if (params->maxCellActiveStreakGens != -1) {
+        lookaheadStreakTimer.Reset(~active);
+        lookaheadStreakTimer.Start(active);
+        lookaheadStreakTimer.Tick();
+      }
+
+      bool genResult = CheckConditionsOn(currentGen + i, hasInteracted, interactionStart, gen, stable, prev, active, everActive, lookaheadTimer, lookaheadStreakTimer);
+      if (i == lookaheadGens)
+        lookaheadStats->Record(i, !genResult);
+      if (!genResult)
+        return {false, FocusSet()};
+    }
+  }
+
+  LifeState oneOrTwoUnknownNeighbours = (stable.unknown0 ^ stable.unknown1) & ~stable.unknown2 & ~stable.unknown3;
+
+  int bestPrioGen = -1;
+  int bestPrioDistance = -1;
+  LifeState bestPrioCandidates(false);
+
+  int bestEdgyGen = -1;
+  LifeState bestEdgyCandidates(false);
+
+  int bestAnyGen = -1;
+  LifeState bestAnyCandidates(false);
+
+  for (unsigned l = 0; l < lookaheadGens; l++) {
+    for (unsigned i = 1; i + l < lookaheadSize; i++) {
+      if (!genHasFocusable[i])
+        continue;
+      LifeState prioCandidates = allForcedInactive[i+l] & allFocusable[i];
+      LifeState edgyPrioCandidates = oneOrTwoUnknownNeighbours & prioCandidates;
+
+      if (params->focusHeuristic == CascadeFocus && !edgyPrioCandidates.IsEmpty()) {
+        return {true, FocusSet(edgyPrioCandidates, lookahead[i].glanceableUnknown, lookahead[i - 1], currentGen + i - 1, l == 0)};
+      }
+
+      if (params->focusHeuristic != EarliestFocus && bestPrioGen == -1 && !prioCandidates.IsEmpty()) {
+        bestPrioGen = i;
+        bestPrioDistance = l;
+        bestPrioCandidates = prioCandidates;
+      }
+
+      LifeState edgyCandidates = allFocusable[i] & oneOrTwoUnknownNeighbours;
+
+      if (params->focusHeuristic == CascadeFocus && l == 0 && bestEdgyGen == -1 && !edgyCandidates.IsEmpty()) {
+        bestEdgyGen = i;
+        bestEdgyCandidates = edgyCandidates;
+      }
+
+      if (l == 0 && bestAnyGen == -1 && !allFocusable[i].IsEmpty()) {
+        bestAnyGen = i;
+        bestAnyCandidates = allFocusable[i];
+      }
+    }
+
+    for (unsigned i = 1; i + l < lookaheadSize; i++) {
+      allForcedInactive[i] = allForcedInactive[i].ZOI();
+    }
+  }
+
+  if (bestPrioGen != -1) {
+    int i = bestPrioGen;
+    return {true, FocusSet(bestPrioCandidates, lookahead[i].glanceableUnknown, lookahead[i - 1], currentGen + i - 1, bestPrioDistance == 0)};
+  }
+
+  if (bestEdgyGen != -1) {
+    int i = bestEdgyGen;
+    return {true, FocusSet(bestEdgyCandidates, lookahead[i].glanceableUnknown, lookahead[i - 1], currentGen + i - 1, false)};
+  }
+
+  if (bestAnyGen != -1) {
+    int i = bestAnyGen;
+    return {true, FocusSet(bestAnyCandidates, lookahead[i].glanceableUnknown, lookahead[i - 1], currentGen + i - 1, false)};
+  }
+
+  // This shouldn't be reached
+  return {false, FocusSet()};
+}
+
+template <unsigned CountdownMax>
+std::pair<int, int> SearchState<CountdownMax>::ChooseBranchCell(std::pair<int, int> focus) const {
+  switch (params->cellHeuristic) {
+  case LeastUnknownCell:
+    return stable.LeastUnknownNeighbour(focus);
+  case MostConstrainedCell:
+    return stable.MostConstrainedNeighbour(focus);
+  default:
+    return stable.UnknownNeighbour(focus);
+  }
+}
+
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::SanityCheck() {
+  assert((stable.unknownStable & stable.glanced).IsEmpty());
+  assert((stable.unknownStable & stable.glancedON).IsEmpty());
+  assert((stable.state & stable.glanced).IsEmpty());
+  assert((stable.state & stable.glancedON).IsEmpty());
+  assert((stable.unknownStable & stable.glanced).IsEmpty());
+  assert((stable.unknownStable & stable.glancedON).IsEmpty());
+  assert((stable.glanced & stable.glancedON).IsEmpty());
+
+  assert((current.unknownStable & ~current.unknown).IsEmpty());
+  assert((stable.state & stable.unknownStable).IsEmpty());
+  assert((current.unknownStable & ~stable.unknownStable).IsEmpty());
+
+  //assert((~pendingFocuses & pendingGlanceable).IsEmpty());
+
+}
+
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::Search() {
+  SearchStep();
+}
+
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::SearchStep() {
+  if (control->cancelled && control->cancelled->load(std::memory_order_relaxed))
+    return;
+
+  stats->nodes++;
+  if (probe)
+    probe->estimate += 1 / share;
+  else if (params->progressInterval > 0 && (stats->nodes & 0xfff) == 0)
+    ReportProgress();
+
+  if (focus == std::pair(-1, -1) && pendingFocuses.focuses.IsEmpty()) {
+    bool consistent = Traced(stats->tracer, TracePropagateStable, [&] { return stable.PropagateStable().consistent; });
+    if (!consistent)
+      return FinishBranch();
+
+    LifeState cells = stable.Vulnerable() & stable.unknownStable;
+    bool testconsistent = Traced(stats->tracer, TraceTestUnknowns, [&] { return stable.TestUnknowns(cells).consistent; });
+    if (!testconsistent)
+      return FinishBranch();
+
+    if (params->hasForbidden && !params->forbidden.Propagate(stable))
+      return FinishBranch();
+
+    if (params->hasSymmetry && !PropagateSymmetry())
+      return FinishBranch();
+
+    TransferStableToCurrent();
+
+    if (!Traced(stats->tracer, TraceTryAdvance, [&] { return TryAdvance(); }))
+      return FinishBranch();
+
+    if (!AdvancePendingReactions())
+      return FinishBranch();
+
+    bool passed;
+    std::tie(passed, pendingFocuses) = Traced(stats->tracer, TraceFindFocuses, [&] { return FindFocuses(); });
+
+    if (!passed)
+      return FinishBranch();
+
+    // SanityCheck();
+  }
+
+  if (focus == std::pair(-1, -1)) {
+    focus = pendingFocuses.NextFocus();
+    if (focus == std::pair(-1, -1))
+      throw std::runtime_error("no focus");
+
+    bool focusIsGlancing =
+        params->skipGlancing && pendingFocuses.glanceable.Get(focus) &&
+        pendingFocuses.currentState.StillGlancingFor(focus, stable);
+
+    if(focusIsGlancing) {
+      pendingFocuses.Erase(focus);
+
+      if (!pendingFocuses.isForcedInactive || stable.unknown2.Get(focus) ||
+          stable.unknown3.Get(focus)) { // TODO: handle overpopulation better
+        share /= 2;
+
+        if (!probe || probe->Coin()) {
+          SearchState nextState = Traced(stats->tracer, TraceCopy, [&] { return *this; });
+          nextState.lookaheadSlot++;
+          nextState.stable.glancedON.Set(focus);
+          nextState.SearchStep();
+
+          if (probe)
+            return;
+        }
+      }
+
+      stable.glanced.Set(focus);
+      pendingFocuses.Erase(focus);
+      focus = {-1, -1};
+
+      [[clang::musttail]]
+      return SearchStep();
+    }
+  }
+
+  bool focusIsDetermined = pendingFocuses.currentState.KnownNext(stable, focus);
+
+  auto cell = ChooseBranchCell(focus);
+  if (focusIsDetermined || cell == std::pair(-1, -1)) {
+    pendingFocuses.Erase(focus);
+    focus = {-1, -1};
+
+    [[clang::musttail]]
+    return SearchStep();
+  }
+
+  share /= 2;
+
+  // A probe only follows one of the branches
+  if (!probe || probe->Coin()) {
+    bool which = params->branchOnFirst;
+    SearchState nextState = Traced(stats->tracer, TraceCopy, [&] { return *this; });
+
+    nextState.hasReported = false;
+    nextState.lookaheadSlot++;
+
+    nextState.stable.SetCell(cell, which);
+
+    nextState.pendingFocuses.currentState.state.SetCellUnsafe(cell, which);
+    nextState.pendingFocuses.currentState.unknown.Erase(cell);
+    nextState.pendingFocuses.currentState.unknownStable.Erase(cell);
+
+    bool doRecurse = true;
+
+    if (doRecurse) {
+      auto result = Traced(stats->tracer, TracePropagateColumn,
+                           [&] { return nextState.stable.PropagateColumn(cell.first); });
+      bool columnChanged = result.changed;
+      // if(result.consistent && result.edgesChanged)
+      //   result = nextState.stable.PropagateStable();
+      if(result.consistent && (columnChanged || result.changed))
+        nextState.TransferStableToCurrentColumn(cell.first);
+
+      doRecurse = result.consistent;
+    }
+
+    if (doRecurse && params->hasSymmetry)
+      doRecurse = nextState.SetOrbit(cell, which);
+
+    if (doRecurse && pendingFocuses.isForcedInactive && stable.stateZOI.Get(focus)) {
+      // See whether this choice keeps the focus stable in the next generation
+      auto [focusNext, focusUnknown, focusUnknownStable] =
+        nextState.pendingFocuses.currentState.NextForCell(nextState.stable, focus);
+      doRecurse = !focusUnknownStable && (focusUnknown || focusNext == nextState.stable.state.Get(focus));
+    }
+
+    if (doRecurse) {
+      doRecurse = Traced(stats->tracer, TraceQuicklook, [&] {
+        LifeUnknownState quicklook = Traced(stats->tracer, TraceUncertainStep, [&] {
+          return nextState.pendingFocuses.currentState.UncertainStepMaintaining(nextState.stable);
+        });
+        LifeState quickactive = quicklook.ActiveComparedTo(nextState.stable);
+        LifeState quickeveractive = everActive | quickactive;
+        return CheckConditionsOn(pendingFocuses.currentGen + 1, hasInteracted, interactionStart, quicklook, nextState.stable, current,
+                                 quickactive, quickeveractive, activeTimer, streakTimer);
+      });
+    }
+
+    if (doRecurse)
+      nextState.SearchStep();
+    else
+      nextState.FinishBranch();
+
+    if (probe)
+      return;
+  }
+  {
+    bool which = !params->branchOnFirst;
+    SearchState &nextState = *this; // Does not copy
+
+    nextState.stable.SetCell(cell, which);
+
+    nextState.pendingFocuses.currentState.state.SetCellUnsafe(cell, which);
+    nextState.pendingFocuses.currentState.unknown.Erase(cell);
+    nextState.pendingFocuses.currentState.unknownStable.Erase(cell);
+
+    bool doRecurse = true;
+
+    if (doRecurse) {
+      auto result = Traced(stats->tracer, TracePropagateColumn,
+                           [&] { return nextState.stable.PropagateColumn(cell.first); });
+      bool columnChanged = result.changed;
+      // if(result.consistent && result.edgesChanged)
+      //   result = nextState.stable.PropagateStable();
+      if(result.consistent && (columnChanged || result.changed))
+        nextState.TransferStableToCurrentColumn(cell.first);
+
+      doRecurse = result.consistent;
+    }
+
+    if (doRecurse && params->hasSymmetry)
+      doRecurse = nextState.SetOrbit(cell, which);
+
+    if (doRecurse && pendingFocuses.isForcedInactive && stable.stateZOI.Get(focus)) {
+      // See whether this choice keeps the focus stable in the next generation
+      auto [focusNext, focusUnknown, focusUnknownStable] =
+        nextState.pendingFocuses.currentState.NextForCell(nextState.stable, focus);
+      doRecurse = !focusUnknownStable && (focusUnknown || focusNext == nextState.stable.state.Get(focus));
+    }
+
+    if (doRecurse) {
+      doRecurse = Traced(stats->tracer, TraceQuicklook, [&] {
+        LifeUnknownState quicklook = Traced(stats->tracer, TraceUncertainStep, [&] {
+          return nextState.pendingFocuses.currentState.UncertainStepMaintaining(nextState.stable);
+        });
+        LifeState quickactive = quicklook.ActiveComparedTo(nextState.stable);
+        LifeState quickeveractive = everActive | quickactive;
+        return CheckConditionsOn(pendingFocuses.currentGen + 1, hasInteracted, interactionStart, quicklook, nextState.stable, current,
+                                 quickactive, quickeveractive, activeTimer, streakTimer);
+      });
+    }
+
+    if (doRecurse)
+      [[clang::musttail]]
+      return nextState.SearchStep();
+
+    FinishBranch();
+  }
+}
+
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::FinishBranch() {
+  if (!probe)
+    stats->finished += share;
+}
+
+// The remaining time is extrapolated from the fraction of the tree
+// finished so far
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::ReportProgress() const {
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> sinceLast = now - stats->lastProgress;
+  if (sinceLast.count() < params->progressInterval)
+    return;
+  stats->lastProgress = now;
+
+  std::chrono::duration<double> elapsed = now - stats->startTime;
+  *out << "Progress: " << 100 * stats->finished << "% Nodes: " << stats->nodes << " Elapsed: " << elapsed.count();
+  if (stats->finished > 0)
+    *out << " Remaining: " << elapsed.count() * (1 - stats->finished) / stats->finished;
+  *out << std::endl;
+}
+
+// Give the images of `cell` under the symmetry the same value
+template <unsigned CountdownMax>
+bool SearchState<CountdownMax>::SetOrbit(std::pair<int, int> cell, bool which) {
+  LifeState single;
+  single.Set(cell);
+  LifeState orbit = params->symmetry.Orbit(single);
+  orbit.Erase(cell);
+
+  for (auto image : orbit.OnCells()) {
+    if (!stable.unknownStable.Get(image)) {
+      if (stable.state.Get(image) != which)
+        return false;
+      continue;
+    }
+
+    stable.SetCell(image, which);
+    auto result = stable.PropagateColumn(image.first);
+    if (!result.consistent)
+      return false;
+    TransferStableToCurrentColumn(image.first);
+  }
+  return true;
+}
+
+// Copy every decided stable cell to its images, until nothing changes
+template <unsigned CountdownMax>
+bool SearchState<CountdownMax>::PropagateSymmetry() {
+  while (true) {
+    LifeState symOn = params->symmetry.Orbit(stable.state & ~stable.unknownStable);
+    LifeState symOff = params->symmetry.Orbit(~stable.state & ~stable.unknownStable);
+    if (!(symOn & symOff).IsEmpty())
+      return false;
+
+    LifeState newlyKnown = (symOn | symOff) & stable.unknownStable;
+    if (newlyKnown.IsEmpty())
+      return true;
+
+    stable.state |= symOn & newlyKnown;
+    stable.unknownStable &= ~newlyKnown;
+    if (!Traced(stats->tracer, TracePropagateStable, [&] { return stable.PropagateStable().consistent; }))
+      return false;
+  }
+}
+
+template <unsigned CountdownMax>
+bool SearchState<CountdownMax>::PassesFilter() const {
+  LifeUnknownState lookahead = current;
+  for (unsigned lookaheadGen = currentGen; lookaheadGen <= params->maxFilterGen; lookaheadGen++) {
+    for (auto &f : params->filters) {
+      if (f.gen != lookaheadGen)
+        continue;
+
+      bool allKnown = (f.mask & lookahead.unknown).IsEmpty();
+      bool matches = ((lookahead.state ^ f.state) & f.mask).IsEmpty();
+      if (!allKnown || !matches)
+        return false;
+    }
+    if (lookaheadGen < params->maxFilterGen)
+      lookahead = lookahead.UncertainStepMaintaining(stable);
+  }
+  return true;
+}
+
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::ReportSolution(unsigned period) {
+  if (probe)
+    return;
+
+  if (control->onSolution) {
+    if (AcceptSolution())
+      control->onSolution(CurrentSolution(period));
+  } else if(params->jsonlResults)
+    ReportJsonSolution(period);
+  else if(params->pipeResults)
+    ReportPipeSolution();
+  else
+    ReportFullSolution();
+}
+
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::ReportFullSolution() {
+  if (!AcceptSolution())
+    return;
+
+  if (params->sweepPatterns.size() > 1) {
+    auto offset = params->sweepOffsets[sweepIndex];
+    *out << "Offset: " << offset.first << " " << offset.second << std::endl;
+  }
+
+  *out << "Winner:" << std::endl;
+  *out << "x = 0, y = 0, rule = LifeBellman" << std::endl;
+  LifeState starting = StartingPattern();
+  LifeState startingStableOff = params->startingStable & ~params->startingPattern;
+  LifeState state = starting | (stable.state & ~startingStableOff);
+  LifeState marked = stable.unknownStable | (stable.state & ~startingStableOff);
+  *out << LifeBellmanRLEFor(state, marked) << std::endl;
+
+  if(params->stabiliseResults) {
+    LifeState completed = Traced(stats->tracer, TraceCompleteStable, [&] {
+      return stable.CompleteStable(params->stabiliseResultsTimeout, params->minimiseResults);
+    });
+
+    if(!completed.IsEmpty()){
+      // *out << "Completed:" << std::endl;
+      // *out << "x = 0, y = 0, rule = LifeHistory" << std::endl;
+      // LifeState remainingHistory = stable.unknownStable & ~completed.ZOI().MooreZOI(); // ZOI().MooreZOI() gives a BigZOI without the diagonals
+      // LifeState stator = params->stator | (stable.state & ~everActive) | (completed & ~stable.state);
+      // LifeHistoryState history(starting | (completed & ~startingStableOff), remainingHistory , LifeState(), stator);
+      // *out << history.RLE() << std::endl;
+
+      *out << "Completed Plain:" << std::endl;
+      *out << ((completed & ~startingStableOff) | starting).RLE() << std::endl;
+      allSolutions->push_back((completed & ~startingStableOff) | starting);
+    } else {
+      // *out << "Completion failed!" << std::endl;
+      // *out << "x = 0, y = 0, rule = LifeHistory" << std::endl;
+      // LifeHistoryState history;
+      // *out << history.RLE() << std::endl;
+      *out << "Completed Plain:" << std::endl;
+      *out << LifeState().RLE() << std::endl;
+    }
+  }
+}
+
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::ReportPipeSolution() {
+  if (params->blacklist.Matches(stable.state, everActive))
+    return;
+
+  if (params->dedupeResults && !solutionIndex->Add(SolutionIndex::Key(StartingPattern(), stable.state)))
+    return;
+
+  LifeState completed = Traced(stats->tracer, TraceCompleteStable, [&] {
+    return stable.CompleteStable(params->stabiliseResultsTimeout, params->minimiseResults);
+  });
+
+  if(completed.IsEmpty())
+    return;
+
+  LifeState starting = StartingPattern();
+  LifeState startingStableOff = params->startingStable & ~params->startingPattern;
+
+  *out << "x = 0, y = 0, rule = B3/S23" << std::endl;
+  *out << ((completed & ~startingStableOff) | starting).RLE() << "!" << std::endl << std::endl;
+}
+
+// Whether the solution passes the blacklist and filters and hasn't
+// been reported before
+template <unsigned CountdownMax>
+bool SearchState<CountdownMax>::AcceptSolution() {
+  if (params->blacklist.Matches(stable.state, everActive))
+    return false;
+
+  if (!params->filters.empty() && !PassesFilter())
+    return false;
+
+  if (params->dedupeResults && !solutionIndex->Add(SolutionIndex::Key(StartingPattern(), stable.state)))
+    return false;
+
+  return true;
+}
+
+template <unsigned CountdownMax>
+Solution SearchState<CountdownMax>::CurrentSolution(unsigned period) {
+  LifeState startingStableOff = params->startingStable & ~params->startingPattern;
+
+  Solution solution;
+  solution.starting = StartingPattern();
+  solution.stable = stable.state & ~startingStableOff;
+  solution.unknown = stable.unknownStable;
+  if (params->stabiliseResults) {
+    LifeState completed = Traced(stats->tracer, TraceCompleteStable, [&] {
+      return stable.CompleteStable(params->stabiliseResultsTimeout, params->minimiseResults);
+    });
+    if (!completed.IsEmpty())
+      solution.completed = (completed & ~startingStableOff) | solution.starting;
+  }
+  solution.everActive = everActive;
+  solution.interactionStart = interactionStart;
+  solution.recoveryGen = recoveryGen;
+  solution.period = period;
+  solution.offset = params->sweepOffsets[sweepIndex];
+  return solution;
+}
+
+// One JSON object per line. The RLEs never contain quotes, backslashes
+// or newlines, so need no escaping.
+template <unsigned CountdownMax>
+void SearchState<CountdownMax>::ReportJsonSolution(unsigned period) {
+  if (!AcceptSolution())
+    return;
+
+  Solution solution = CurrentSolution(period);
+
+  std::ostringstream record;
+  record << "{\"partial\":\"" << LifeBellmanRLEFor(solution.starting | solution.stable, solution.unknown | solution.stable) << "\"";
+
+  record << ",\"completed\":";
+  if (!solution.completed.IsEmpty())
+    record << "\"" << solution.completed.RLE() << "!\"";
+  else
+    record << "null";
+
+  record << ",\"interactionStart\":" << solution.interactionStart
+         << ",\"recoveryGen\":" << solution.recoveryGen
+         << ",\"everActivePop\":" << solution.everActive.GetPop()
+         << ",\"stablePop\":" << stable.state.GetPop();
+
+  if (params->sweepPatterns.size() > 1)
+    record << ",\"offset\":[" << solution.offset.first << "," << solution.offset.second << "]";
+  if (period != 0)
+    record << ",\"period\":" << period;
+
+  std::chrono::duration<double> now = std::chrono::system_clock::now().time_since_epoch();
+  record << ",\"time\":" << std::fixed << std::setprecision(3) << now.count() << "}\n";
+
+  resultWriter->Write(record.str());
+}
+
+inline void PrintSummary(std::vector<LifeState> &pats, std::ostream &out) {
+  out << "Summary:" << std::endl;
+  out << "x = 0, y = 0, rule = B3/S23" << std::endl;
+  for (unsigned i = 0; i < pats.size(); i += 8) {
+    std::vector<LifeState> row =
+      std::vector<LifeState>(pats.begin() + i, pats.begin() + std::min((unsigned)pats.size(), i + 8));
+    out << RowRLE(row) << std::endl;
+  }
+}
+
+struct SearchEstimate {
+  unsigned probes;
+  double nodes;
+  double standardError;
+  double seconds;
+
+  // Adds the estimate of another, independent search
+  void Add(const SearchEstimate &other) {
+    probes += other.probes;
+    nodes += other.nodes;
+    standardError = std::sqrt(standardError * standardError + other.standardError * other.standardError);
+    seconds += other.seconds;
+  }
+
+  void Print(std::ostream &out) const {
+    out << "Estimated nodes: " << nodes << " +- " << standardError << " (" << probes << " probes)" << std::endl;
+    out << "Estimated time: " << seconds << std::endl;
+  }
+};
+
+// Probes from `root` until `seconds` have passed. They have their own
+// lookahead caches and stats, so leave the real search as it was.
+template <unsigned CountdownMax>
+SearchEstimate EstimateSearch(const SearchState<CountdownMax> &root, unsigned seconds) {
+  LookaheadStats lookaheadStats = *root.lookaheadStats;
+  LookaheadCaches lookaheadCaches;
+  SearchStats stats;
+  Probe probe;
+
+  double sum = 0;
+  double sumSquares = 0;
+  unsigned probes = 0;
+  std::chrono::duration<double> elapsed;
+  do {
+    SearchState<CountdownMax> state = root;
+    state.lookaheadStats = &lookaheadStats;
+    state.lookaheadCaches = &lookaheadCaches;
+    state.stats = &stats;
+    state.probe = &probe;
+
+    probe.estimate = 0;
+    state.Search();
+    sum += probe.estimate;
+    sumSquares += probe.estimate * probe.estimate;
+    probes++;
+
+    elapsed = std::chrono::steady_clock::now() - stats.startTime;
+  } while (elapsed.count() < seconds);
+
+  SearchEstimate result;
+  result.probes = probes;
+  result.nodes = sum / probes;
+  double variance = std::max(0.0, sumSquares / probes - result.nodes * result.nodes);
+  result.standardError = std::sqrt(variance / probes);
+  // Assuming nodes cost the same in the probes as in the search
+  result.seconds = result.nodes * elapsed.count() / stats.nodes;
+  return result;
+}
+
+template <unsigned CountdownMax>
+void RunSearch(SearchParams &params, RotorCatalogue &rotorCatalogue, std::ostream &out, const SearchControl &control) {
+  std::vector<LifeState> allSolutions;
+  SolutionIndex solutionIndex;
+  if (!params.resultsIndexFile.empty())
+    solutionIndex.Open(params.resultsIndexFile);
+  SearchStats stats;
+  std::unique_ptr<Tracer> tracer;
+  if (params.tracePhases || params.traceCounters || !params.traceFile.empty())
+    tracer = std::make_unique<Tracer>(params.traceFile, params.traceCounters);
+  std::unique_ptr<ResultWriter> resultWriter;
+  if (params.jsonlResults)
+    resultWriter = std::make_unique<ResultWriter>(out);
+
+  // Each offset is searched on its own, exactly as if it had been given
+  // alone. Their branching follows their own focuses, so they share the
+  // output, the results index and the summary, but not the search tree.
+  unsigned offsets = params.sweepPatterns.size();
+  std::vector<LookaheadStats> lookaheadStats(offsets, LookaheadStats(params.lookaheadGens));
+  std::vector<LookaheadCaches> lookaheadCaches(offsets);
+  std::vector<SearchState<CountdownMax>> searches;
+  for (unsigned i = 0; i < offsets; i++)
+    searches.emplace_back(params, allSolutions, rotorCatalogue, solutionIndex, lookaheadStats[i], lookaheadCaches[i], stats, out, resultWriter.get(), control, i);
+
+  if (params.estimateSeconds > 0) {
+    SearchEstimate estimate = EstimateSearch(searches[0], std::max(1u, params.estimateSeconds / offsets));
+    for (unsigned i = 1; i < offsets; i++)
+      estimate.Add(EstimateSearch(searches[i], std::max(1u, params.estimateSeconds / offsets)));
+    estimate.Print(out);
+    if (params.estimateOnly)
+      return;
+    stats = SearchStats();
+  }
+  stats.tracer = tracer.get();
+
+  for (auto &search : searches) {
+    search.share = 1.0 / offsets;
+    search.Search();
+  }
+
+  if (resultWriter)
+    resultWriter->Close();
+
+  if (params.printSummary)
+    PrintSummary(allSolutions, out);
+
+  if (params.printStats)
+    stats.Print(out);
+
+  if (params.tracePhases || params.traceCounters)
+    tracer->Print(out);
+}
+
+// Throws if the parameters don't make sense together
+inline void RunJob(SearchParams &params, RotorCatalogue &rotorCatalogue, std::ostream &out, const SearchControl &control = {}) {
+  if (params.lookaheadGens < 2 || params.lookaheadGens > maxLookaheadGens)
+    throw std::runtime_error("lookahead-gens must be between 2 and " + std::to_string(maxLookaheadGens) + "!");
+  if (params.adaptiveLookahead &&
+      (params.lookaheadGensRange.first < 2 || params.lookaheadGensRange.second > maxLookaheadGens ||
+       params.lookaheadGens < params.lookaheadGensRange.first || params.lookaheadGens > params.lookaheadGensRange.second))
+    throw std::runtime_error("lookahead-gens-range must be within [2, " + std::to_string(maxLookaheadGens) + "] and contain lookahead-gens!");
+
+  int timerGens = std::max(params.maxCellActiveWindowGens, params.maxCellActiveStreakGens);
+
+  if (timerGens == -1)
+    RunSearch<0>(params, rotorCatalogue, out, control);
+  else if ((unsigned)timerGens <= cellTimerWidths[0])
+    RunSearch<cellTimerWidths[0]>(params, rotorCatalogue, out, control);
+  else if ((unsigned)timerGens <= cellTimerWidths[1])
+    RunSearch<cellTimerWidths[1]>(params, rotorCatalogue, out, control);
+  else if ((unsigned)timerGens <= cellTimerWidths[2])
+    RunSearch<cellTimerWidths[2]>(params, rotorCatalogue, out, control);
+  else if ((unsigned)timerGens <= cellTimerWidths[3])
+    RunSearch<cellTimerWidths[3]>(params, rotorCatalogue, out, control);
+  else
+    throw std::runtime_error("max-cell-active-window and max-cell-active-streak can be at most " + std::to_string(cellTimerWidths[3]) + "!");
+}
+
+// Runs a search from other code, calling `onSolution` for each solution
+// rather than printing anything. `cancelled`, if given, may be set from
+// another thread to stop the search early. `params` must have been
+// prepared, and the catalogue may be shared with searches on other
+// threads.
+inline void Search(SearchParams &params, std::function<void(const Solution &)> onSolution,
+            const std::atomic<bool> *cancelled, RotorCatalogue &rotorCatalogue) {
+  SearchParams quiet = params;
+  quiet.printSummary = false;
+  quiet.printStats = false;
+  quiet.jsonlResults = false;
+
+  std::ostream nowhere(nullptr);
+  SearchControl control = {onSolution, cancelled};
+  RunJob(quiet, rotorCatalogue, nowhere, control);
+}
+
+inline void Search(SearchParams &params, std::function<void(const Solution &)> onSolution,
+            const std::atomic<bool> *cancelled = nullptr) {
+  RotorCatalogue rotorCatalogue;
+  if (!params.rotorCatalogueFile.empty())
+    rotorCatalogue.Open(params.rotorCatalogueFile);
+  Search(params, onSolution, cancelled, rotorCatalogue);
+}
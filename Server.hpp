@@ -0,0 +1,201 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// A stream buffer over a socket, so that whatever a job prints reaches
+// the client each time the stream is flushed. Sets `failed` once the
+// client can no longer be written to.
+class SocketStreamBuf : public std::streambuf {
+public:
+  SocketStreamBuf(int infd, std::atomic<bool> &outfailed) : fd{infd}, failed{outfailed} {
+    setp(buffer.data(), buffer.data() + buffer.size());
+  }
+  ~SocketStreamBuf() { sync(); }
+
+protected:
+  int overflow(int ch) override;
+  int sync() override;
+
+private:
+  int fd;
+  std::atomic<bool> &failed;
+  std::array<char, 4096> buffer;
+};
+
+inline int SocketStreamBuf::overflow(int ch) {
+  if (sync() == -1)
+    return traits_type::eof();
+  if (ch != traits_type::eof()) {
+    *pptr() = ch;
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+inline int SocketStreamBuf::sync() {
+  const char *data = pbase();
+  size_t remaining = pptr() - pbase();
+  setp(buffer.data(), buffer.data() + buffer.size());
+
+  while (remaining > 0) {
+    // MSG_NOSIGNAL, so a client that hangs up doesn't kill the server
+    ssize_t sent = send(fd, data, remaining, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR)
+        continue;
+      failed = true;
+      return -1;
+    }
+    data += sent;
+    remaining -= sent;
+  }
+  return 0;
+}
+
+// Runs a job for each connection to a Unix-domain socket, on a fixed
+// pool of threads. A job is everything the client sends before shutting
+// down its side of the connection, and everything the job writes to
+// `out` is streamed back. The connection is closed when the job ends.
+// `cancelled` is set if the client hangs up first, so the job can stop.
+class Server {
+public:
+  using Job = std::function<void(const std::string &input, std::ostream &out, const std::atomic<bool> &cancelled)>;
+
+  Server(const std::string &inpath, unsigned threads, Job inrunJob) : path{inpath}, workerCount{threads}, runJob{inrunJob} {}
+
+  // Never returns
+  void Serve();
+
+private:
+  std::string path;
+  unsigned workerCount;
+  Job runJob;
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<int> connections;
+
+  int Listen() const;
+  void Work();
+  void Handle(int connection) const;
+};
+
+inline int Server::Listen() const {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    std::cerr << "Socket path too long: " << path << std::endl;
+    exit(1);
+  }
+  std::strcpy(address.sun_path, path.c_str());
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    std::cerr << "Could not create socket: " << std::strerror(errno) << std::endl;
+    exit(1);
+  }
+
+  // Left behind by a previous server
+  unlink(path.c_str());
+
+  if (bind(listener, (sockaddr *)&address, sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0) {
+    std::cerr << "Could not listen on " << path << ": " << std::strerror(errno) << std::endl;
+    exit(1);
+  }
+  return listener;
+}
+
+inline void Server::Serve() {
+  int listener = Listen();
+
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < workerCount; i++)
+    workers.emplace_back(&Server::Work, this);
+
+  while (true) {
+    int connection = accept(listener, nullptr, nullptr);
+    if (connection < 0) {
+      if (errno != EINTR)
+        std::cerr << "accept failed: " << std::strerror(errno) << std::endl;
+      continue;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      connections.push_back(connection);
+    }
+    ready.notify_one();
+  }
+}
+
+inline void Server::Work() {
+  while (true) {
+    int connection;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ready.wait(lock, [this] { return !connections.empty(); });
+      connection = connections.front();
+      connections.pop_front();
+    }
+    Handle(connection);
+    close(connection);
+  }
+}
+
+inline void Server::Handle(int connection) const {
+  std::string input;
+  std::array<char, 4096> chunk;
+  while (true) {
+    ssize_t received = recv(connection, chunk.data(), chunk.size(), 0);
+    if (received < 0 && errno == EINTR)
+      continue;
+    if (received <= 0)
+      break;
+    input.append(chunk.data(), received);
+  }
+
+  std::atomic<bool> cancelled = false;
+  std::atomic<bool> finished = false;
+
+  // The client has already shut down its side, so the socket only
+  // reports POLLHUP once it has closed the connection entirely
+  std::thread watcher([&] {
+    pollfd hangup = {connection, 0, 0};
+    while (!finished && !cancelled) {
+      if (poll(&hangup, 1, 100) > 0 && (hangup.revents & (POLLHUP | POLLERR)))
+        cancelled = true;
+    }
+  });
+
+  {
+    SocketStreamBuf buffer(connection, cancelled);
+    std::ostream out(&buffer);
+    try {
+      runJob(input, out, cancelled);
+    } catch (const std::exception &e) {
+      out << "Error: " << e.what() << std::endl;
+    }
+    out.flush();
+  }
+
+  finished = true;
+  watcher.join();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "LifeAPI.h"
+
+// The solutions reported so far, identified by the starting pattern and
+// the ON stable cells, whatever is still unknown. With a file, those
+// from previous runs are loaded at the start and new ones are appended
+// as they are reported.
+class SolutionIndex {
+public:
+  std::unordered_set<uint64_t> seen;
+
+  static uint64_t Key(const LifeState &starting, const LifeState &stable) {
+    return HASH::hash64(starting.GetSparseHash(), stable.GetSparseHash());
+  }
+
+  void Open(const std::string &filename);
+  bool Add(uint64_t key);
+
+private:
+  std::ofstream file;
+};
+
+// One hex key per line, '#' comments are ignored
+inline void SolutionIndex::Open(const std::string &filename) {
+  std::ifstream existing(filename);
+  for (std::string line; std::getline(existing, line);) {
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::istringstream fields(line);
+    uint64_t key;
+    if (!(fields >> std::hex >> key)) {
+      throw std::runtime_error("Bad line in results index " + filename + ": " + line);
+    }
+    seen.insert(key);
+  }
+
+  file.open(filename, std::ios::app);
+  if (!file) {
+    throw std::runtime_error("Could not open results index " + filename);
+  }
+}
+
+// Whether the solution is new
+inline bool SolutionIndex::Add(uint64_t key) {
+  if (!seen.insert(key).second)
+    return false;
+  if (file.is_open())
+    file << std::hex << std::setw(16) << std::setfill('0') << key << std::dec << std::endl;
+  return true;
+}
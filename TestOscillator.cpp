@@ -0,0 +1,57 @@
+// Checks the oscillator hashes used to skip oscillators that have been
+// seen before.
+//
+//   ./TestOscillator
+
+#include <iostream>
+#include <string>
+
+#include "Oscillator.hpp"
+
+// The mold, a p4 whose phases two generations apart are reflections of
+// each other
+const char *mold = "3b2o$2bo2bo$o2bobo$4bo$ob2o$bo!";
+
+unsigned failures = 0;
+
+void Check(bool ok, const std::string &what) {
+  if (ok)
+    return;
+  failures++;
+  std::cout << "Failed: " << what << std::endl;
+}
+
+uint64_t HashFromPhase(const LifeState &pattern, unsigned phase) {
+  LifeStableState stable;
+  LocalStepper stepper(stable, {pattern, LifeState(), LifeState(), LifeState()});
+  for (unsigned i = 0; i < phase; i++)
+    stepper.Step();
+  unsigned period = OscillationPeriod(stepper, 20);
+  return OscillatorHash(stepper, period);
+}
+
+int main() {
+  LifeStableState stable;
+  LifeState pattern = LifeState::Parse(mold, 20, 20);
+  LocalStepper stepper(stable, {pattern, LifeState(), LifeState(), LifeState()});
+  Check(OscillationPeriod(stepper, 20) == 4, "the mold has period 4");
+
+  uint64_t hash = HashFromPhase(pattern, 0);
+  Check(hash != 0, "phases that repeat under reflection don't cancel");
+  for (unsigned phase = 1; phase < 4; phase++)
+    Check(HashFromPhase(pattern, phase) == hash, "starting phase " + std::to_string(phase) + " gives the same hash");
+  LifeState reflected = pattern;
+  reflected.FlipX();
+  Check(HashFromPhase(reflected, 0) == hash, "reflecting the oscillator gives the same hash");
+
+  RotorCatalogue catalogue;
+  catalogue.AddOscillator(hash);
+  Check(!catalogue.KnownOscillator(0), "a hash of 0 isn't known after adding the mold");
+
+  if (failures > 0) {
+    std::cout << failures << " failures" << std::endl;
+    return 1;
+  }
+  std::cout << "All oscillator hashes behave" << std::endl;
+  return 0;
+}
@@ -0,0 +1,138 @@
+// Checks searches over several reactions, and sweeps over several
+// offsets, against searching each reaction and offset on its own.
+//
+//   ./TestSearch
+
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "toml/toml.hpp"
+
+#include "Search.hpp"
+
+// A glider into a small search area, and far from it a second glider
+// that a fixed eater takes at generation 10, several generations after
+// the first glider can interact. The eater is done changing cells by
+// generation 14, so it only passes max-changes counted from its own
+// interaction.
+const char *settings = R"(
+first-active-range = [2, 12]
+active-window-range = [3, 30]
+min-stable-interval = 5
+changes-grace = 4
+max-changes = 3
+
+stabilise-results = true
+skip-glancing = true
+)";
+
+const char *firstGlider = R"(
+pattern = '''
+x = 40, y = 40, rule = LifeHistory
+.A$2.A$3A2$3.8B$3.8B$3.8B$3.8B$3.8B$3.8B$3.8B26$36.2C$36.C.C$38.C$38.2C!
+'''
+)";
+
+const char *secondGlider = R"(
+pattern = '''
+x = 40, y = 40, rule = LifeHistory
+4$3.8B$3.8B$3.8B$3.8B$3.8B$3.8B$3.8B20$31.A$32.A$30.3A4$36.2C$36.C.C$38.C
+$38.2C!
+'''
+)";
+
+const char *secondReaction = R"(
+[[reaction]]
+pattern = '''
+x = 33, y = 33, rule = LifeHistory
+30$31.A$32.A$30.3A!
+'''
+)";
+
+// Each of these has winners on its own
+const std::vector<std::pair<int, int>> sweepOffsets = {{0, 0}, {1, 0}, {-1, 0}, {0, -1}, {-1, -1}};
+
+std::string SweepOffsets(const std::vector<std::pair<int, int>> &offsets) {
+  std::string result = "sweep-offsets = [";
+  for (auto &offset : offsets)
+    result += "[" + std::to_string(offset.first) + ", " + std::to_string(offset.second) + "], ";
+  return result + "]\n";
+}
+
+unsigned failures = 0;
+
+void Check(bool ok, const std::string &what) {
+  if (ok)
+    return;
+  failures++;
+  std::cout << "Failed: " << what << std::endl;
+}
+
+struct Winners {
+  std::set<std::string> partials;
+  std::set<unsigned> interactionStarts;
+};
+
+// Keyed by the offset each winner was found at
+std::map<std::pair<int, int>, Winners> RunByOffset(const std::string &input) {
+  std::istringstream stream(input);
+  auto toml = toml::parse(stream, "test");
+  SearchParams params = SearchParams::FromToml(toml);
+
+  std::map<std::pair<int, int>, Winners> winners;
+  Search(params, [&](const Solution &solution) {
+    Winners &atOffset = winners[solution.offset];
+    atOffset.partials.insert(LifeBellmanRLEFor(solution.starting | solution.stable, solution.unknown | solution.stable));
+    atOffset.interactionStarts.insert(solution.interactionStart);
+  });
+  return winners;
+}
+
+Winners Run(const std::string &input) {
+  return RunByOffset(input)[{0, 0}];
+}
+
+void TestReactions() {
+  Winners first = Run(std::string(settings) + firstGlider);
+  Winners second = Run(std::string(settings) + secondGlider);
+  Winners joint = Run(std::string(settings) + firstGlider + secondReaction);
+
+  Check(!first.partials.empty(), "the first glider alone has winners");
+  Check(second.partials.size() == 1 && second.interactionStarts == std::set<unsigned>{10},
+        "the second glider alone is eaten at generation 10");
+  Check(*first.interactionStarts.begin() + 4 <= 10, "some winners of the first glider interact well before the second");
+
+  // Whatever is placed in the search area, the eater still takes the
+  // second glider, so the joint winners are exactly the first glider's
+  Check(joint.partials == first.partials, "the joint winners are the winners of the first glider");
+  Check(joint.interactionStarts == std::set<unsigned>{10}, "joint winners are reported by the second glider");
+}
+
+void TestSweep() {
+  auto swept = RunByOffset(std::string(settings) + SweepOffsets(sweepOffsets) + firstGlider);
+  Check(swept.size() == sweepOffsets.size(), "the sweep has winners at every offset");
+
+  for (auto &offset : sweepOffsets) {
+    Winners alone = RunByOffset(std::string(settings) + SweepOffsets({offset}) + firstGlider)[offset];
+
+    std::string name = "(" + std::to_string(offset.first) + ", " + std::to_string(offset.second) + ")";
+    Check(!alone.partials.empty(), "searching " + name + " alone has winners");
+    Check(swept[offset].partials == alone.partials, "the sweep finds the same winners at " + name + " as searching it alone");
+  }
+}
+
+int main() {
+  TestReactions();
+  TestSweep();
+
+  if (failures > 0) {
+    std::cout << failures << " failures" << std::endl;
+    return 1;
+  }
+  std::cout << "All searches agree" << std::endl;
+  return 0;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "PerfCounters.hpp"
+
+enum TracePhase {
+  TraceTryAdvance,
+  TraceFindFocuses,
+  TraceQuicklook,
+  TraceOscillation,
+  TraceRecovery,
+  TracePropagateStable,
+  TraceTestUnknowns,
+  TraceCompleteStable,
+  TracePropagateColumn,
+  TraceUncertainStep,
+  TraceCopy,
+  TracePhaseCount,
+};
+
+const std::array<const char *, TracePhaseCount> tracePhaseNames = {
+    "TryAdvance",     "FindFocuses",     "Quicklook",     "Oscillation",
+    "Recovery",       "PropagateStable", "TestUnknowns",  "CompleteStable",
+    "PropagateColumn", "UncertainStep",  "Copy",
+};
+
+// The count and time of each phase, with a histogram of durations in
+// powers of two of nanoseconds, and optionally every span as a Chrome
+// trace event. With `counters`, the hardware counters are also read at
+// the start and end of each phase. Times and counts include those of any
+// phases nested inside, and the counters include the cost of reading
+// them, which is a system call.
+class Tracer {
+public:
+  using Clock = std::chrono::steady_clock;
+  static const unsigned histogramBuckets = 40;
+
+  struct Mark {
+    Clock::time_point time;
+    PerfCounters::Values counts = {};
+  };
+
+  Tracer(const std::string &traceFile, bool counters);
+  ~Tracer();
+
+  Mark Start() const;
+  void Record(TracePhase phase, const Mark &start);
+  void Print(std::ostream &out) const;
+
+private:
+  struct PhaseStats {
+    uint64_t count = 0;
+    uint64_t totalNanos = 0;
+    std::array<uint64_t, histogramBuckets> histogram = {};
+    PerfCounters::Values counts = {};
+  };
+  std::array<PhaseStats, TracePhaseCount> phases;
+
+  std::unique_ptr<PerfCounters> perf;
+  Clock::time_point origin;
+  std::ofstream file;
+  bool firstEvent;
+};
+
+inline Tracer::Tracer(const std::string &traceFile, bool counters) : origin{Clock::now()}, firstEvent{true} {
+  if (counters)
+    perf = std::make_unique<PerfCounters>();
+
+  if (traceFile.empty())
+    return;
+
+  file.open(traceFile);
+  if (!file)
+    throw std::runtime_error("Could not open trace file " + traceFile);
+  file << "{\"traceEvents\":[\n";
+}
+
+inline Tracer::~Tracer() {
+  if (file.is_open())
+    file << "\n]}\n";
+}
+
+inline Tracer::Mark Tracer::Start() const {
+  Mark mark;
+  if (perf)
+    mark.counts = perf->Read();
+  mark.time = Clock::now();
+  return mark;
+}
+
+inline void Tracer::Record(TracePhase phase, const Mark &start) {
+  Clock::time_point end = Clock::now();
+  uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start.time).count();
+
+  PhaseStats &stats = phases[phase];
+  if (perf) {
+    PerfCounters::Values counts = perf->Read();
+    for (unsigned i = 0; i < PerfCounterCount; i++)
+      stats.counts[i] += counts[i] - start.counts[i];
+  }
+  stats.count++;
+  stats.totalNanos += nanos;
+  unsigned bucket = nanos == 0 ? 0 : 64 - __builtin_clzll(nanos);
+  stats.histogram[std::min(bucket, histogramBuckets - 1)]++;
+
+  if (file.is_open()) {
+    std::chrono::duration<double, std::micro> ts = start.time - origin;
+    if (!firstEvent)
+      file << ",\n";
+    firstEvent = false;
+    file << "{\"name\":\"" << tracePhaseNames[phase] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+         << std::fixed << std::setprecision(3) << ts.count() << ",\"dur\":" << nanos / 1000.0 << "}";
+  }
+}
+
+inline void Tracer::Print(std::ostream &out) const {
+  out << "Phases:" << std::endl;
+  for (unsigned i = 0; i < TracePhaseCount; i++) {
+    const PhaseStats &stats = phases[i];
+    if (stats.count == 0)
+      continue;
+
+    out << tracePhaseNames[i] << ": count " << stats.count << " total " << stats.totalNanos / 1e9
+        << "s mean " << stats.totalNanos / stats.count << "ns, log2(ns) histogram";
+    for (unsigned bucket = 0; bucket < histogramBuckets; bucket++) {
+      if (stats.histogram[bucket] != 0)
+        out << " " << bucket << ":" << stats.histogram[bucket];
+    }
+    out << std::endl;
+  }
+
+  if (!perf)
+    return;
+  if (!perf->Available()) {
+    out << "Performance counters unavailable" << std::endl;
+    return;
+  }
+
+  out << "Counters per call:" << std::endl;
+  for (unsigned i = 0; i < TracePhaseCount; i++) {
+    const PhaseStats &stats = phases[i];
+    if (stats.count == 0)
+      continue;
+
+    out << tracePhaseNames[i] << ":";
+    for (unsigned c = 0; c < PerfCounterCount; c++)
+      out << " " << perfCounterNames[c] << " " << stats.counts[c] / stats.count;
+    double cycles = stats.counts[PerfCycles];
+    double ipc = cycles == 0 ? 0 : stats.counts[PerfInstructions] / cycles;
+    out << " IPC " << std::round(ipc * 100) / 100 << std::endl;
+  }
+}
+
+// Times `f` as the given phase if there is a tracer. The timing lives in
+// this frame rather than the caller's, so callers can still musttail.
+template <typename F>
+inline auto Traced(Tracer *tracer, TracePhase phase, F f) {
+  if (!tracer)
+    return f();
+
+  Tracer::Mark start = tracer->Start();
+  if constexpr (std::is_void_v<decltype(f())>) {
+    f();
+    tracer->Record(phase, start);
+  } else {
+    auto result = f();
+    tracer->Record(phase, start);
+    return result;
+  }
+}
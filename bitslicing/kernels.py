@@ -0,0 +1,179 @@
+# Generates Kernels.hpp, the per-cell rules shared by the column and
+# whole-grid propagators and steppers:
+#
+#   python3 bitslicing/kernels.py > Kernels.hpp
+#
+# The tables are small enough to minimise exactly here, so unlike the
+# other scripts this doesn't need espresso, and the output is the same
+# wherever it is run.
+
+from common import *
+
+# The inputs of both kernels, most significant first. Counts are of the
+# 3x3 neighbourhood including the centre, and saturate: on2..on0 at 7
+# and unk1..unk0 at 3.
+innames = ["stateunk", "stateon", "on2", "on1", "on0", "unk1", "unk0"]
+
+def decode(row):
+    bits = [(row >> (len(innames) - 1 - i)) & 1 for i in range(len(innames))]
+    stateunk, stateon, on2, on1, on0, unk1, unk0 = bits
+    if stateunk and stateon:
+        return None
+    center = UNKNOWN if stateunk else (ON if stateon else OFF)
+    oncount = on2 * 4 + on1 * 2 + on0
+    unkcount = unk1 * 2 + unk0
+    if center == ON and oncount == 0: return None
+    if center == UNKNOWN and unkcount == 0: return None
+    return center, oncount, unkcount
+
+def neighbours(center, oncount, unkcount):
+    on = oncount - (1 if center == ON else 0)
+    unk = unkcount - (1 if center == UNKNOWN else 0)
+    return on, unk
+
+# As in stable_count.py and stable_signal.py. Outputs that are ignored
+# by the caller are DONTCARE: setting UNKNOWN cells when the centre is
+# known, signals when there are no UNKNOWN cells to signal, and anything
+# when the neighbourhood aborts.
+stable_outnames = ["set_off", "set_on", "signal_off", "signal_on", "abort"]
+
+def stable_rule(center, oncount, unkcount):
+    # stable_count.py only covers these
+    if oncount > 6:
+        return None
+
+    on, unk = neighbours(center, oncount, unkcount)
+    r = range(on, on + unk + 1)
+    on_possible = 2 in r or 3 in r
+    off_possible = any(k != 3 for k in r)
+
+    if center == UNKNOWN:
+        return {"set_off": not on_possible, "set_on": not off_possible,
+                "signal_off": False, "signal_on": False, "abort": False}
+
+    stays = [k for k in r if life_stable(center, k)]
+    if len(stays) == 0:
+        return {"set_off": DONTCARE, "set_on": DONTCARE,
+                "signal_off": DONTCARE, "signal_on": DONTCARE, "abort": True}
+
+    if unk == 0:
+        signal_off = DONTCARE
+        signal_on = DONTCARE
+    else:
+        signal_off = stays == [on]
+        signal_on = stays == [on + unk]
+    return {"set_off": DONTCARE, "set_on": DONTCARE,
+            "signal_off": signal_off, "signal_on": signal_on, "abort": False}
+
+# As in unknown_step.py
+step_outnames = ["next_on", "unknown"]
+
+def step_rule(center, oncount, unkcount):
+    if oncount + unkcount > 9:
+        return None
+
+    on, unk = neighbours(center, oncount, unkcount)
+    centers = [ON, OFF] if center == UNKNOWN else [center]
+    results = {life_rule(c, k) for c in centers for k in range(on, on + unk + 1)}
+    return {"next_on": results == {ON}, "unknown": len(results) == 2}
+
+def table(rule, outname):
+    onset, dcset = [], []
+    for row in range(1 << len(innames)):
+        decoded = decode(row)
+        value = DONTCARE if decoded is None else rule(*decoded)
+        if isinstance(value, dict):
+            value = value[outname]
+        if value is None:
+            value = DONTCARE
+        if value == DONTCARE:
+            dcset.append(row)
+        elif value:
+            onset.append(row)
+    return onset, dcset
+
+# Terms are (bits, mask) pairs: the inputs in `mask` must equal `bits`
+def prime_implicants(onset, dcset):
+    terms = {(row, (1 << len(innames)) - 1) for row in onset + dcset}
+    primes = set()
+    while terms:
+        merged = set()
+        used = set()
+        for a in terms:
+            for b in terms:
+                if a[1] != b[1] or a[0] >= b[0]:
+                    continue
+                diff = a[0] ^ b[0]
+                if diff & (diff - 1) == 0:
+                    merged.add((a[0] & ~diff, a[1] & ~diff))
+                    used.add(a)
+                    used.add(b)
+        primes |= terms - used
+        terms = merged
+    return primes
+
+def covers(term, row):
+    return row & term[1] == term[0]
+
+def literals(term):
+    return bin(term[1]).count("1")
+
+# Essential primes, then greedily the prime covering the most remaining
+# rows, preferring fewer literals
+def minimise(onset, dcset):
+    primes = sorted(prime_implicants(onset, dcset), key=lambda t: (literals(t), -t[1], t[0]))
+    remaining = set(onset)
+    cover = []
+    for row in sorted(onset):
+        covering = [p for p in primes if covers(p, row)]
+        if len(covering) == 1 and covering[0] not in cover:
+            cover.append(covering[0])
+    for p in cover:
+        remaining -= {row for row in remaining if covers(p, row)}
+    while remaining:
+        best = max(primes, key=lambda p: (sum(covers(p, row) for row in remaining), -literals(p)))
+        cover.append(best)
+        remaining -= {row for row in remaining if covers(best, row)}
+    return sorted(cover, key=lambda t: (-t[1], t[0]))
+
+def term_code(term):
+    code = []
+    for i, name in enumerate(innames):
+        bit = 1 << (len(innames) - 1 - i)
+        if term[1] & bit:
+            code.append(name if term[0] & bit else f"(~{name})")
+    return " & ".join(code) if code else "~0ULL"
+
+def emit_kernel(name, comment, rule, outnames):
+    params = ", ".join(f"uint64_t {n}" for n in innames)
+    outs = ", ".join(f"uint64_t &{n}" for n in outnames)
+    print(comment)
+    print(f"constexpr inline void {name}({params},")
+    print(f"{' ' * (len(name) + 23)}{outs}) {{")
+    for outname in outnames:
+        onset, dcset = table(rule, outname)
+        for term in minimise(onset, dcset):
+            print(f"  {outname} |= {term_code(term)};")
+    print("}")
+
+print("""#pragma once
+
+// Generated by bitslicing/kernels.py, do not edit. Regenerate with
+// `make Kernels.hpp`.
+
+#include <cstdint>
+
+// Each kernel ORs its results into the outputs, for 64 cells at once.
+// Counts are of the 3x3 neighbourhood including the centre, and must
+// saturate: on2..on0 at 7 and unk1..unk0 at 3.
+""")
+emit_kernel("StableRuleKernel",
+            "// Whether a cell of a stable state forces UNKNOWN cells: setting the\n"
+            "// centre (only meaningful when it is UNKNOWN), or signalling every\n"
+            "// UNKNOWN cell of the neighbourhood (only when there is one). abort\n"
+            "// means no choice of the UNKNOWN cells keeps the centre stable.",
+            stable_rule, stable_outnames)
+print()
+emit_kernel("UncertainStepKernel",
+            "// The next generation of a cell, ON, OFF or UNKNOWN",
+            step_rule, step_outnames)
@@ -0,0 +1,93 @@
+# Runs Barrister on some inputs once per branching heuristic, and
+# reports the number of search nodes and the time taken for each.
+#
+# python3 scripts/compare_heuristics.py [--all] [--timeout SECONDS] [input.toml ...]
+
+import argparse
+import itertools
+import os
+import subprocess
+import tempfile
+
+default_inputs = [
+    "inputs/eater2.toml",
+    "inputs/glancingtest.toml",
+    "inputs/glider.toml",
+    "inputs/snark.toml",
+]
+
+focus_heuristics = ["cascade", "priority", "earliest"]
+cell_heuristics = ["first", "fewest-unknown-neighbours", "most-constrained"]
+value_orders = ["on-first", "off-first"]
+
+def configurations(everything):
+    if everything:
+        for f, c, v in itertools.product(focus_heuristics, cell_heuristics, value_orders):
+            yield {"focus-heuristic": f, "cell-heuristic": c, "value-order": v}
+        return
+
+    # Vary one choice at a time from the default
+    default = {"focus-heuristic": focus_heuristics[0],
+               "cell-heuristic": cell_heuristics[0],
+               "value-order": value_orders[0]}
+    yield default
+    for key, options in [("focus-heuristic", focus_heuristics),
+                         ("cell-heuristic", cell_heuristics),
+                         ("value-order", value_orders)]:
+        for o in options[1:]:
+            config = dict(default)
+            config[key] = o
+            yield config
+
+def with_overrides(toml, overrides):
+    lines = [l for l in toml.split("\n")
+             if l.split("=")[0].strip() not in overrides]
+    header = [f'{k} = {v}' for k, v in overrides.items()]
+    return "\n".join(header + lines)
+
+def run(barrister, path, config, timeout):
+    overrides = {k: f'"{v}"' for k, v in config.items()}
+    overrides["print-stats"] = "true"
+    overrides["print-summary"] = "false"
+    overrides["stabilise-results"] = "false"
+
+    with open(path) as f:
+        toml = with_overrides(f.read(), overrides)
+
+    with tempfile.NamedTemporaryFile("w", suffix=".toml", delete=False) as f:
+        f.write(toml)
+        temp = f.name
+
+    try:
+        p = subprocess.run([barrister, temp], capture_output=True, text=True, timeout=timeout)
+        out = p.stdout
+    except subprocess.TimeoutExpired:
+        return None
+    finally:
+        os.unlink(temp)
+
+    stats = {"winners": out.count("Winner:")}
+    for line in out.split("\n"):
+        if line.startswith("Nodes: "):
+            stats["nodes"] = int(line.split()[1])
+        if line.startswith("Time: "):
+            stats["time"] = float(line.split()[1])
+    return stats
+
+parser = argparse.ArgumentParser()
+parser.add_argument("inputs", nargs="*", default=default_inputs)
+parser.add_argument("--all", action="store_true", help="try every combination of heuristics")
+parser.add_argument("--timeout", type=float, default=600)
+parser.add_argument("--barrister", default="./Barrister")
+args = parser.parse_args()
+
+for path in args.inputs:
+    print(path)
+    print(f"  {'focus':10} {'cell':26} {'value':10} {'nodes':>12} {'time':>9} {'winners':>8}")
+    for config in configurations(args.all):
+        stats = run(args.barrister, path, config, args.timeout)
+        name = f"  {config['focus-heuristic']:10} {config['cell-heuristic']:26} {config['value-order']:10}"
+        if stats is None:
+            print(f"{name} {'timeout':>12}")
+        else:
+            print(f"{name} {stats['nodes']:12} {stats['time']:9.2f} {stats['winners']:8}")